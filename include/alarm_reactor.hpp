@@ -0,0 +1,85 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef ALARM_REACTOR_HPP
+#define ALARM_REACTOR_HPP
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/select.h>
+#include <set>
+
+#include "alarm_scheduler.hpp"
+#include "alarm_req_listener.hpp"
+
+// Runs the alarm agent from a single epoll loop, as an alternative to the
+// listener, worker, scheduler and SNMP handler threads. The loop waits on:
+//  - the alarm request socket (via ZMQ_FD)
+//  - a timerfd, armed for when the scheduler next has alarms due
+//  - Net-SNMP's sockets and timeout (from snmp_select_info)
+//  - an eventfd, used to stop the loop.
+//
+// Alarm requests are therefore handled, and the resulting traps sent, on
+// the one thread. The scheduler and listener must have been set up to be
+// driven from an event loop.
+class AlarmReactor
+{
+public:
+  AlarmReactor(AlarmScheduler* alarm_scheduler,
+               AlarmReqListener* alarm_req_listener,
+               pthread_mutex_t& snmp_lock) :
+    _alarm_scheduler(alarm_scheduler),
+    _alarm_req_listener(alarm_req_listener),
+    _snmp_lock(snmp_lock),
+    _epoll_fd(-1),
+    _timer_fd(-1),
+    _event_fd(-1),
+    _zmq_fd(-1),
+    _timer_armed_for(0)
+  {}
+
+  ~AlarmReactor();
+
+  // Creates the epoll set and the timer and event file descriptors.
+  bool init();
+
+  // Runs the loop until stop is called.
+  void run();
+
+  // Stops the loop. This is safe to call from a signal handler.
+  void stop();
+
+private:
+  enum {MAX_EVENTS = 16};
+
+  // Keeps the epoll set in step with the sockets Net-SNMP wants polled.
+  void update_snmp_fds(int num_fds, fd_set* fds);
+
+  // Arms the timer for when the scheduler next needs to send alarms.
+  void arm_timer(uint64_t check_time);
+
+  bool add_fd(int fd);
+
+  AlarmScheduler* _alarm_scheduler;
+  AlarmReqListener* _alarm_req_listener;
+  pthread_mutex_t& _snmp_lock;
+
+  int _epoll_fd;
+  int _timer_fd;
+  int _event_fd;
+  int _zmq_fd;
+
+  // The time the timer is armed for (0 if it isn't armed).
+  uint64_t _timer_armed_for;
+
+  // The Net-SNMP sockets currently in the epoll set.
+  std::set<int> _snmp_fds;
+};
+
+#endif
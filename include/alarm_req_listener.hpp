@@ -12,6 +12,8 @@
 
 #include <vector>
 #include <string>
+#include <deque>
+#include <pthread.h>
 #include <semaphore.h>
 
 #include "alarm_scheduler.hpp"
@@ -19,14 +21,28 @@
 // Singleton which provides a listener thead to accept alarm requests from
 // clients via ZMQ, then generates alarmActiveState/alarmClearState inform
 // notifications as appropriate based upon these requests.
+//
+// The listener uses a ROUTER socket, so many clients can have requests in
+// flight at once.  Each request is acknowledged as soon as it has been
+// validated and queued; the alarm scheduler is called from a separate worker
+// thread, so clients don't wait on the SNMP agent lock.  If the worker falls
+// too far behind, further requests are rejected (with a "busy" reply) until
+// it catches up - clients periodically re-raise their alarms anyway.
+//
+// Alternatively the listener can be driven from an event loop (see
+// AlarmReactor), in which case it doesn't start any threads and requests are
+// passed to the scheduler as soon as they're read.
 
 class AlarmReqListener
 {
 public:
   AlarmReqListener(AlarmScheduler* alarm_scheduler) :
+    _worker_running(false),
     _ctx(NULL),
     _sck(NULL),
-    _alarm_scheduler(alarm_scheduler)
+    _alarm_scheduler(alarm_scheduler),
+    _inline_requests(false),
+    _stopping(false)
   {}
 
   // Initialize ZMQ context and start listener thread.
@@ -35,10 +51,35 @@ public:
   // Gracefully stop the listener thread and remove ZMQ context.
   void stop();
 
+  // Initialize ZMQ context and socket, to be driven from an event loop
+  // rather than by the listener thread.
+  bool open();
+
+  // Close the ZMQ socket and context opened by open().
+  void close();
+
+  // The file descriptor to poll for readability to find out when
+  // handle_ready_requests should be called (see ZMQ_FD).
+  int get_fd();
+
+  // Reads and handles all the requests that are waiting on the socket.
+  void handle_ready_requests();
+
 private:
   enum {ZMQ_PORT = 6664};
 
+  // The most requests that can be waiting for the worker thread.
+  enum {MAX_QUEUED_REQUESTS = 1000};
+
+  // A validated request, waiting for the worker thread.
+  struct Request
+  {
+    enum Type {ISSUE_ALARM, ISSUE_ALARMS, SYNC_ALARMS} type;
+    AlarmTriggers alarms;
+  };
+
   static void* listener_thread(void* alarm_req_listener);
+  static void* worker_thread(void* alarm_req_listener);
 
   bool zmq_init_ctx();
   bool zmq_init_sck();
@@ -47,12 +88,22 @@ private:
   void zmq_clean_sck();
 
   void listener();
+  void worker();
+
+  // Validates a request, queues it and acknowledges it.
+  void handle_msg(std::vector<std::string>& msg);
+
+  // Passes on or queues a request, returning false if the queue is full.
+  bool queue_request(const Request& request);
+  void process_request(const Request& request);
 
-  bool next_msg(std::vector<std::string>& msg);
+  bool next_msg(std::vector<std::string>& msg, int flags = 0);
 
-  void reply(const char* response);
+  void reply(const std::vector<std::string>& envelope, const char* response);
 
   pthread_t _thread;
+  pthread_t _worker;
+  bool _worker_running;
 
   pthread_mutex_t _start_mutex;
   pthread_cond_t  _start_cond;
@@ -62,6 +113,16 @@ private:
   AlarmScheduler* _alarm_scheduler;
 
   sem_t* _term_sem;
+
+  // Whether requests are passed straight to the scheduler, rather than
+  // queued for the worker thread.
+  bool _inline_requests;
+
+  // Requests waiting for the worker thread.
+  std::deque<Request> _queue;
+  pthread_mutex_t _queue_lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t _queue_cond = PTHREAD_COND_INITIALIZER;
+  bool _stopping;
 };
 
 #endif
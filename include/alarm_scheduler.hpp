@@ -13,12 +13,15 @@
 #include <time.h>
 
 #include <string>
+#include <deque>
 #include <map>
+#include <vector>
+#include <utility>
 #include <cstdint>
 
 #include "alarm_table_defs.hpp"
 #include "alarm_trap_sender.hpp"
-#include "timer_heap.h"
+#include "timer_wheel.hpp"
 #include "utils.h"
 #ifdef UNIT_TEST
 #include "pthread_cond_var_helper.h"
@@ -27,8 +30,8 @@
 #endif
 
 /// AlarmTimer. This holds information about an alarm that's scheduled to be
-/// sent, in a format that can be placed into the heap.
-class AlarmTimer : public HeapableTimer
+/// sent, in a format that can be placed onto the timer wheel.
+class AlarmTimer : public WheelTimer
 {
 public:
   AlarmTimer(unsigned int index) :
@@ -37,77 +40,104 @@ public:
     _index(index)
  {}
 
-  // Updates the pop time of the AlarmTimer, and rebalances the heap to
+  // Updates the pop time of the AlarmTimer, and moves it on the wheel to
   // account for the changed pop time
   void update_pop_time(uint64_t time_to_add)
   {
     _pop_time = Utils::get_time() + time_to_add;
-    _heap->rebalance(this);
+    _wheel->reschedule(this);
   }
 
-  // Removes the AlarmTimer from the heap, and sets the pop time/severity
+  // Removes the AlarmTimer from the wheel, and sets the pop time/severity
   // to clearly invalid values (that won't cause INFORMS to be sent in error
   // cases)
-  void remove_from_heap()
+  void remove_from_wheel()
   {
     _pop_time = UINT64_MAX;
     _severity = AlarmDef::Severity::UNDEFINED_SEVERITY;
-    _heap->remove(this);
+    _retry_sinks.clear();
+    _wheel->remove(this);
   }
 
   const unsigned int index() { return _index; }
   AlarmDef::Severity severity() { return _severity; }
   void set_severity(AlarmDef::Severity severity) { _severity = severity; }
-  bool in_heap() { return (_heap != nullptr); }
+  bool in_wheel() { return (_wheel != nullptr); }
   uint64_t get_pop_time() const { return _pop_time; }
 
+  // The sinks to resend the alarm to when it pops, if it's a resend to sinks
+  // that didn't respond. Empty means the alarm is sent to all the sinks.
+  std::vector<snmp_session*>& retry_sinks() { return _retry_sinks; }
+
 private:
   uint64_t _pop_time;
   AlarmDef::Severity _severity;
   unsigned int _index;
+  std::vector<snmp_session*> _retry_sinks;
 };
 
-/// SingleAlarmManager. This class manages a single alarm. It holds a pointer
-/// to the alarm that's been scheduled to be sent to the NMS, the severity
+/// SingleAlarmManager. This class manages a single alarm. It holds the timer
+/// for the alarm that's been scheduled to be sent to the NMS, the severity
 /// that we last sent to the NMS, and holds the logic for comparing these
 /// and deciding if we resend/reschedule the alarm.
 class SingleAlarmManager
 {
 public:
-  SingleAlarmManager(AlarmTimer* alarm_timer,
+  SingleAlarmManager(unsigned int index,
                      AlarmDef::Severity severity) :
-    _alarm_timer(alarm_timer),
+    _alarm_timer(index),
     _severity(severity)
   {}
 
-  ~SingleAlarmManager();
-
-  // Updates the alarm in the heap's severity, and its time to pop
+  // Updates the severity of the alarm on the wheel, and its time to pop.
+  // The alarm is sent to all the sinks, even if it was only due to be
+  // resent to some of them.
   void change_schedule(AlarmDef::Severity new_severity,
                        uint64_t time_to_delay_in_ms);
 
-  AlarmTimer* alarm_timer() { return _alarm_timer; }
+  AlarmTimer* alarm_timer() { return &_alarm_timer; }
   AlarmDef::Severity severity() { return _severity; }
 
-  // Updates the alarm in the heap and the Active Alarm Table
+  // Updates the severity we last sent for the alarm
   void update_alarm_state(AlarmTableDef& alarm_table_def);
 
   // Determines whether this alarm should be resent after failure
   bool should_resend_alarm(AlarmDef::Severity severity)
   {
     // Resend the alarm if its severity and the current severity match,
-    // and there isn't already an alarm in the heap waiting to update
+    // and there isn't already an alarm on the wheel waiting to update
     // the severity.
-    return ((_severity == severity) && (!_alarm_timer->in_heap()));
+    return ((_severity == severity) && (!_alarm_timer.in_wheel()));
+  }
+
+  // Determines whether this alarm is already waiting to be resent, in this
+  // severity, to sinks that didn't respond
+  bool is_resending_alarm(AlarmDef::Severity severity)
+  {
+    return ((_severity == severity) &&
+            (_alarm_timer.in_wheel()) &&
+            (_alarm_timer.severity() == severity) &&
+            (!_alarm_timer.retry_sinks().empty()));
   }
 
 private:
-  AlarmTimer* _alarm_timer;
+  AlarmTimer _alarm_timer;
   AlarmDef::Severity _severity;
 };
 
 typedef unsigned int AlarmIndex;
 
+// An alarm that's due to be sent, and the sinks to send it to (all of them
+// if there aren't any).
+struct AlarmToSend
+{
+  AlarmTableDef* alarm_table_def;
+  std::vector<snmp_session*> sinks;
+};
+
+// A batch of (issuer, identifier) alarm triggers.
+typedef std::vector<std::pair<std::string, std::string>> AlarmTriggers;
+
 // This class accepts alarm triggers, checks that they correspond to valid
 // alarms, and passes schedules sending alarms to the alarm trap sender to
 // send as SNMP INFORMs.
@@ -122,11 +152,14 @@ public:
   const static uint64_t ALARM_RESYNC_DELAY = 0;
   const static uint64_t ALARM_INCREASED_DELAY = 0;
 
-  // Constructor/Destructor
+  // Constructor/Destructor. If run_threads is false, the scheduler doesn't
+  // start its own threads to send alarms - instead the caller must call
+  // send_due_alarms by the time returned from get_next_check_time.
   AlarmScheduler(AlarmTableDefs* alarm_table_defs, 
                  std::set<NotificationType> snmp_notifications,
                  std::string hostname,
-                 pthread_mutex_t& lock);
+                 pthread_mutex_t& snmp_lock,
+                 bool run_threads = true);
   virtual ~AlarmScheduler();
 
   // Generates an alarmActiveState inform if the identified alarm is not
@@ -137,19 +170,49 @@ public:
   virtual void issue_alarm(const std::string& issuer,
                            const std::string& identifier);
 
-  static void* heap_sender_function(void* data);
+  // As issue_alarm, for a batch of alarms.  The batch is validated up front,
+  // then applied under a single acquisition of the lock.  Invalid alarms
+  // in the batch are skipped.
+  virtual void issue_alarms(const AlarmTriggers& alarms);
+
+  static void* wheel_sender_function(void* data);
+
+  void wheel_sender();
+
+  // Returns the time (in ms) by which send_due_alarms should next be called,
+  // or UINT64_MAX if no alarms are scheduled. This may change whenever an
+  // alarm is issued.
+  uint64_t get_next_check_time();
 
-  void heap_sender();
+  // Sends all the alarms that are now due, from the calling thread. Only
+  // used if the scheduler isn't running its own threads.
+  void send_due_alarms();
 
-  // Runs through all currently active alarms and adds them to the alarm heap
-  // to send immediately.
+  static void* dispatcher_function(void* data);
+
+  // Sends the alarms that the wheel thread has found are due, in the order
+  // they became due.
+  void dispatcher();
+
+  // Runs through all currently active alarms and adds them to the alarm wheel
+  // to send, most severe first. They're sent immediately unless a resync
+  // rate has been set.
   virtual void sync_alarms();
 
-  // Handles the case where an INFORM sent by the trap sender timed out.
-  // _lock must already be held before calling this.
+  // Limits the rate at which alarms are resent by sync_alarms, using a token
+  // bucket. Each alarm is sent to every sink, so this is also the rate per
+  // sink. Up to burst alarms are sent at once, and after that they're sent
+  // at alarms_per_second. A rate of 0 means there's no limit.
+  void set_resync_rate(unsigned int alarms_per_second, unsigned int burst);
+
+  // Handles the case where an INFORM sent by the trap sender timed out. The
+  // alarm is resent to just that sink. This is called with the agent lock
+  // held.
   // @params alarm_table_def - Definition of the alarm (index/severity) we
   //                           tried to send.
-  void handle_failed_alarm(AlarmTableDef& alarm_table_def);
+  // @params sink - The session for the sink that didn't respond.
+  void handle_failed_alarm(AlarmTableDef& alarm_table_def,
+                           snmp_session* sink);
 
   // Whether the program has terminated
   volatile bool _terminated;
@@ -159,30 +222,90 @@ private:
                                  AlarmDef::Severity severity,
                                  uint64_t alarm_pop_time_ms);
 
-  void remove_outdated_alarm_from_heap(SingleAlarmManager* single_alarm_manager);
+  void remove_outdated_alarm_from_wheel(SingleAlarmManager* single_alarm_manager);
+
+  // Takes all the alarms that are due off the wheel, updating their state.
+  // _lock must be held.
+  void pop_due_alarms(std::deque<AlarmToSend>& alarms_to_send);
+
+  // Passes alarms to the trap sender and updates the Active Alarm Table,
+  // taking the agent lock for each. The scheduler lock mustn't be held.
+  void send_alarms(std::deque<AlarmToSend>& alarms_to_send);
+
+  // Takes a token from the resync token bucket, returning how long (in ms)
+  // until it's available. _lock must be held.
+  uint64_t take_resync_token();
+
+  // Reschedules an alarm for a new severity.  _lock must be held.  Returns
+  // whether the wheel sender needs to be signalled.
+  bool schedule_alarm(AlarmIndex index, AlarmDef::Severity severity);
 
   bool validate_alarm_trigger(std::string identifier,
                               AlarmIndex& index,
                               unsigned int& severity);
 
-  AlarmTableDefs* _alarm_table_defs;
-  TimerHeap _alarm_heap;
-
-  // Map holding all alarms. This maps the index of an alarm to information
-  // about the alarm (its current severity (the severity we last tried to send
-  // to the NMS) and its representation in the heap).
-  std::map<AlarmIndex, SingleAlarmManager*> _all_alarms_state;
+  // Returns the state for the given alarm index, or NULL if there's no
+  // alarm with that index.
+  SingleAlarmManager* alarm_state(AlarmIndex index)
+  {
+    AlarmIndex offset = index - _first_alarm_index;
+    if ((index < _first_alarm_index) || (offset >= _alarm_slots.size()))
+    {
+      return NULL;
+    }
+
+    int slot = _alarm_slots[offset];
+    return (slot < 0) ? NULL : &_all_alarms_state[slot];
+  }
 
-  // This lock protects access to the _all_alarms_state map and the _alarm_heap,
-  // and should be taken whenever reading/writing to these structures.  It must
-  // also protect Net-SNMP accesses.
-  pthread_mutex_t& _lock;
+  AlarmTableDefs* _alarm_table_defs;
+  TimerWheel _alarm_wheel;
+
+  // Table holding all alarms, in order of alarm index. Each entry holds
+  // information about the alarm (its current severity (the severity we last
+  // tried to send to the NMS) and its representation on the wheel). This is
+  // built when we start and never resized, as the wheel holds pointers into it.
+  std::vector<SingleAlarmManager> _all_alarms_state;
+
+  // The slot in _all_alarms_state of each alarm index, offset from the first
+  // alarm index, or -1 if there's no alarm with that index.
+  AlarmIndex _first_alarm_index;
+  std::vector<int> _alarm_slots;
+
+  // This lock protects access to the _all_alarms_state table and the _alarm_wheel,
+  // and should be taken whenever reading/writing to these structures.
+  pthread_mutex_t _lock;
+
+  // The agent lock, which protects Net-SNMP accesses (sending traps and
+  // updating the alarm tables). The agent lock may be held while taking
+  // _lock, but not the other way round.
+  pthread_mutex_t& _snmp_lock;
+
+  // The resync token bucket (as a generic cell rate algorithm). Each token
+  // is worth _resync_interval_us, and the bucket can hold _resync_burst_us
+  // worth. _resync_tat_us is the time (in us) at which the bucket will
+  // next be full. These are protected by _lock.
+  uint64_t _resync_interval_us;
+  uint64_t _resync_burst_us;
+  uint64_t _resync_tat_us;
+
+  // Whether the scheduler runs its own wheel and dispatch threads.
+  bool _run_threads;
 #ifdef UNIT_TEST
   MockPThreadCondVar* _cond;
 #else
   CondVar* _cond;
 #endif
-  pthread_t _heap_sender_thread;
+  pthread_t _wheel_sender_thread;
+
+  // Alarms that are due to be sent, waiting for the dispatch thread. This is
+  // protected by _dispatch_lock, which may be taken while holding _lock but
+  // is never held while taking any other lock.
+  std::deque<AlarmToSend> _dispatch_queue;
+  bool _dispatch_terminated;
+  pthread_mutex_t _dispatch_lock;
+  pthread_cond_t _dispatch_cond;
+  pthread_t _dispatch_thread;
 };
 
 #endif
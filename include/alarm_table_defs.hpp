@@ -11,11 +11,30 @@
 #define ALARM_TABLE_DEFS_HPP
 
 #include <map>
+#include <vector>
+#include <unordered_set>
 
 #include "alarmdefinition.h"
 
+// Single copies of the strings used by a set of alarm table definitions.
+// Strings are never removed, and don't move once stored (elements of an
+// unordered_set stay put when it grows).
+class AlarmTableStrings
+{
+public:
+  const std::string* intern(const std::string& str)
+  {
+    return &*(_strings.insert(str).first);
+  }
+
+private:
+  std::unordered_set<std::string> _strings;
+};
+
 // Container for data needed to generate entries of the Alarm Model Table
-// and ITU Alarm Table.
+// and ITU Alarm Table. The strings are interned in the AlarmTableDefs that
+// built the definition, so this is a small view onto strings shared between
+// all its definitions that use them.
 class AlarmTableDef
 {
 public:
@@ -25,29 +44,32 @@ public:
 
   AlarmTableDef() :
     _valid(false),
-    _alarm_definition(),
-    _severity_details() {}
-
-  AlarmTableDef(const AlarmDef::AlarmDefinition alarm_definition,
-                const AlarmDef::SeverityDetails severity_details) :
-    _valid(true),
-    _alarm_definition(alarm_definition),
-    _severity_details(severity_details) {}
+    _index(0),
+    _alarm_cause(),
+    _severity(AlarmDef::UNDEFINED_SEVERITY),
+    _name(&EMPTY_STRING),
+    _description(&EMPTY_STRING),
+    _details(&EMPTY_STRING),
+    _cause(&EMPTY_STRING),
+    _effect(&EMPTY_STRING),
+    _action(&EMPTY_STRING),
+    _extended_details(&EMPTY_STRING),
+    _extended_description(&EMPTY_STRING) {}
 
   unsigned int state() const;
 
-  const std::string& name() const     {return _alarm_definition._name;}
-  unsigned int alarm_index() const    {return _alarm_definition._index;} 
-  AlarmDef::Cause alarm_cause() const {return _alarm_definition._cause;}
+  const std::string& name() const     {return *_name;}
+  unsigned int alarm_index() const    {return _index;}
+  AlarmDef::Cause alarm_cause() const {return _alarm_cause;}
 
-  AlarmDef::Severity severity() const             {return _severity_details._severity;}
-  const std::string& description() const          {return _severity_details._description;}
-  const std::string& details() const              {return _severity_details._details;}
-  const std::string& cause() const                {return _severity_details._cause;}
-  const std::string& effect() const               {return _severity_details._effect;}
-  const std::string& action() const               {return _severity_details._action;}
-  const std::string& extended_details() const     {return _severity_details._extended_details;}
-  const std::string& extended_description() const {return _severity_details._extended_description;}
+  AlarmDef::Severity severity() const             {return _severity;}
+  const std::string& description() const          {return *_description;}
+  const std::string& details() const              {return *_details;}
+  const std::string& cause() const                {return *_cause;}
+  const std::string& effect() const               {return *_effect;}
+  const std::string& action() const               {return *_action;}
+  const std::string& extended_details() const     {return *_extended_details;}
+  const std::string& extended_description() const {return *_extended_description;}
 
   // LCOV_EXCL_START
   bool is_valid() const     {return _valid;}
@@ -55,10 +77,45 @@ public:
   // LCOV_EXCL_STOP
 
 private:
+  friend class AlarmTableDefs;
+
+  // Definitions are built by AlarmTableDefs, which owns their strings.
+  AlarmTableDef(const AlarmDef::AlarmDefinition& alarm_definition,
+                const AlarmDef::SeverityDetails& severity_details,
+                AlarmTableStrings& strings) :
+    _valid(true),
+    _index(alarm_definition._index),
+    _alarm_cause(alarm_definition._cause),
+    _severity(severity_details._severity),
+    _name(strings.intern(alarm_definition._name)),
+    _description(strings.intern(severity_details._description)),
+    _details(strings.intern(severity_details._details)),
+    _cause(strings.intern(severity_details._cause)),
+    _effect(strings.intern(severity_details._effect)),
+    _action(strings.intern(severity_details._action)),
+    _extended_details(strings.intern(severity_details._extended_details)),
+    _extended_description(strings.intern(severity_details._extended_description)) {}
+
+  // Points this definition at copies of its strings in the given store.
+  void intern_strings(AlarmTableStrings& strings);
+
+  // The strings of the (invalid) default definition.
+  static const std::string EMPTY_STRING;
+
   bool _valid;
 
-  AlarmDef::AlarmDefinition _alarm_definition;
-  AlarmDef::SeverityDetails _severity_details;
+  unsigned int _index;
+  AlarmDef::Cause _alarm_cause;
+  AlarmDef::Severity _severity;
+
+  const std::string* _name;
+  const std::string* _description;
+  const std::string* _details;
+  const std::string* _cause;
+  const std::string* _effect;
+  const std::string* _action;
+  const std::string* _extended_details;
+  const std::string* _extended_description;
 };
 
 // Unique key for alarm table definitions is comprised of alarm index and
@@ -92,9 +149,36 @@ public:
 class AlarmTableDefs
 {
 public:
+  AlarmTableDefs() : _first_index(0) {}
+
+  // The lookup table points into _key_to_def, and the definitions point into
+  // _strings, so both are rebuilt on copy.
+  AlarmTableDefs(const AlarmTableDefs& other) :
+    _key_to_def(other._key_to_def)
+  {
+    intern_strings();
+    build_lookup();
+  }
+
+  AlarmTableDefs& operator=(const AlarmTableDefs& other)
+  {
+    _key_to_def = other._key_to_def;
+    intern_strings();
+    build_lookup();
+    return *this;
+  }
+
   // Generate alarm table definitions based on JSON files on the node
   bool initialize(std::string& path);
 
+  // Build an alarm table definition. Its strings are stored in this object,
+  // so it must not outlive it.
+  AlarmTableDef make_definition(const AlarmDef::AlarmDefinition& alarm_definition,
+                                const AlarmDef::SeverityDetails& severity_details)
+  {
+    return AlarmTableDef(alarm_definition, severity_details, _strings);
+  }
+
   // Retrieve alarm definition for specified index/severity
   AlarmTableDef& get_definition(unsigned int index,
                                 unsigned int severity);
@@ -112,8 +196,25 @@ private:
   bool populate_map(std::string path,
                     std::map<unsigned int, unsigned int>& dup_check);
 
+  // Build the lookup table used by get_definition from _key_to_def.
+  void build_lookup();
+
+  // Point the definitions in _key_to_def at strings in _strings.
+  void intern_strings();
+
+  // The strings of all the definitions built by this object. Like the
+  // definitions, these are only changed while the agent is starting up.
+  AlarmTableStrings _strings;
+
   std::map<AlarmTableDefKey, AlarmTableDef> _key_to_def;
 
+  // Flat lookup table for get_definition. There's a block of NUM_SEVERITIES
+  // entries for each alarm index from _first_index to the highest alarm
+  // index, holding the definition for that index and severity (or NULL).
+  enum {NUM_SEVERITIES = AlarmDef::WARNING + 1};
+  unsigned int _first_index;
+  std::vector<AlarmTableDef*> _lookup;
+
   AlarmTableDef _invalid_def;
 };
 
@@ -15,6 +15,8 @@
 #include <string>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <vector>
 #include <cstdint>
 
 #include "alarm_table_defs.hpp"
@@ -27,42 +29,81 @@ enum NotificationType
 
 class AlarmScheduler;
 
+// Net-SNMP's netsnmp_variable_list and netsnmp_session.
+struct variable_list;
+struct snmp_session;
+
 // Class providing methods for generating alarmActiveState and
 // alarmClearState inform notifications.
 class AlarmTrapSender
 {
 public:
+  // Sets up the trap sender, building the variable bindings for every
+  // alarm definition up front so that sending an INFORM doesn't need to.
   void initialise(AlarmScheduler* alarm_scheduler,
+                  AlarmTableDefs* alarm_table_defs,
                   std::set<NotificationType> snmp_notifications,
-                  std::string hostname)
-    { _alarm_scheduler    = alarm_scheduler;
-      _snmp_notifications = snmp_notifications;
-      _hostname = hostname; }
+                  std::string hostname);
 
-  void send_trap(const AlarmTableDef& alarm_table_def);
+  // Sends the alarm to the given sinks (the sessions Net-SNMP reports in
+  // alarm_trap_send_callback), or to all the sinks if none are given.
+  void send_trap(const AlarmTableDef& alarm_table_def,
+                 const std::vector<snmp_session*>& sinks =
+                                                 std::vector<snmp_session*>());
 
   // Callback triggered when an alarm send completes (either successfully
   // or not).
   //
   // @param op - NETSNMP operation code
+  // @param sink - The session for the sink the alarm was sent to
   // @param alarm_table_def - The alarm entry that was being raised
   void alarm_trap_send_callback(int op,
+                                snmp_session* sink,
                                 const AlarmTableDef& alarm_table_def);
 
   static AlarmTrapSender& get_instance() {return _instance;}
 
 private:
   AlarmTrapSender() : _alarm_scheduler(NULL) {}
+  ~AlarmTrapSender();
   AlarmScheduler* _alarm_scheduler;
   std::set<NotificationType> _snmp_notifications;
   std::string _hostname;
   static AlarmTrapSender _instance;
-  // Sends an RFC3877 compliant trap based upon the specified alarm definition.
-  // net-snmp will handle the retries if needed. 
-  void send_rfc3877_trap(const AlarmTableDef& alarm_table_def);
-  // Sends an Enterprise MIB style trap based upon the specified alarm
-  // definition. net-snmp will handle the retries if needed.
-  void send_enterprise_trap(const AlarmTableDef& alarm_table_def);
+
+  // The variable bindings to send for an alarm definition, for each
+  // notification type (NULL if that type isn't sent).
+  struct TrapTemplates
+  {
+    variable_list* rfc3877;
+    variable_list* enterprise;
+  };
+
+  // Templates for each alarm definition, built by initialise.
+  std::unordered_map<const AlarmTableDef*, TrapTemplates> _templates;
+
+  void free_templates();
+
+  // Builds the variable bindings for an RFC3877 compliant trap based upon
+  // the specified alarm definition.
+  variable_list* build_rfc3877_vars(const AlarmTableDef& alarm_table_def);
+  // Builds the variable bindings for an Enterprise MIB style trap based upon
+  // the specified alarm definition.
+  variable_list* build_enterprise_vars(const AlarmTableDef& alarm_table_def);
+
+  // Sends a trap with the given variable bindings to the given sinks (or
+  // all of them). If there aren't any bindings (as the definition wasn't
+  // known when the templates were built), they're built and freed again
+  // here. net-snmp will handle the retries if needed.
+  void send_vars(variable_list* vars,
+                 variable_list* (AlarmTrapSender::*build)(const AlarmTableDef&),
+                 const AlarmTableDef& alarm_table_def,
+                 const std::vector<snmp_session*>& sinks);
+
+  // Sends an INFORM with the given variable bindings to a single sink.
+  void send_inform(snmp_session* sink,
+                   variable_list* vars,
+                   const AlarmTableDef& alarm_table_def);
 };
 
 #endif
@@ -0,0 +1,451 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef ASTAIRE_HANDLERS_HPP
+#define ASTAIRE_HANDLERS_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "oid_inet_addr.hpp"
+#include "zmq_message_handler.hpp"
+
+class AstaireGlobalStatHandler: public ZMQMessageHandler
+{
+public:
+  AstaireGlobalStatHandler(OID oid, OIDTree* tree) :
+    ZMQMessageHandler(oid, tree),
+    _buckets_needing_resync_oid(oid, "1.0"),
+    _buckets_resynchronized_oid(oid, "2.0"),
+    _entries_resynchronized_oid(oid, "3.0"),
+    _data_resynchronized_oid(oid, "4.0"),
+    _bandwidth_oid(oid, "5.1.2.1"),
+    _data_resynchronized64_oid(oid, "9.0")
+  {
+    // The global stats are the scalars and bandwidth table (astaire 1-5),
+    // and the 64-bit data count (astaire 9).  The connection stats share
+    // the astaire root.
+    _subtrees.clear();
+    for (int table = 1; table <= 5; table++)
+    {
+      _subtrees.push_back(OID(oid, table));
+    }
+    _subtrees.push_back(OID(oid, 9));
+  };
+
+  u_char asn_type(OID oid)
+  {
+    return (_data_resynchronized64_oid.equals(oid)) ? ASN_COUNTER64 : ASN_UNSIGNED;
+  }
+
+  void handle(std::vector<std::string> msgs)
+  {
+    if (msgs.size() >= 7 )
+    {
+      set_field(_buckets_needing_resync_oid, msgs[2]);
+      set_field(_buckets_resynchronized_oid, msgs[3]);
+      set_field(_entries_resynchronized_oid, msgs[4]);
+      set_field(_data_resynchronized_oid, msgs[5]);
+      set_field(_data_resynchronized64_oid, msgs[5]);
+      set_field(_bandwidth_oid, msgs[6]);
+    }
+    else
+    {
+      snmp_log(LOG_INFO, "AstaireGlobalStatHandler received too short globals - %d < 7", (int)msgs.size());
+      _tree->remove(_buckets_needing_resync_oid);
+      _tree->remove(_buckets_resynchronized_oid);
+      _tree->remove(_entries_resynchronized_oid);
+      _tree->remove(_data_resynchronized_oid);
+      _tree->remove(_data_resynchronized64_oid);
+      _tree->remove(_bandwidth_oid);
+    }
+  }
+
+private:
+  // Sets a scalar from a publish field, removing it if the field is
+  // malformed rather than leaving the old value in place.
+  void set_field(const OID& field_oid, const std::string& field)
+  {
+    StatValue value;
+    if (parse_field(field, value))
+    {
+      _tree->set(field_oid, value);
+    }
+    else
+    {
+      _tree->remove(field_oid);
+    }
+  }
+
+  OID _buckets_needing_resync_oid;
+  OID _buckets_resynchronized_oid;
+  OID _entries_resynchronized_oid;
+  OID _data_resynchronized_oid;
+  OID _bandwidth_oid;
+  OID _data_resynchronized64_oid;
+};
+
+class AstaireConnectionStatHandler: public ZMQMessageHandler
+{
+public:
+  AstaireConnectionStatHandler(OID oid, OIDTree* tree) :
+    ZMQMessageHandler(oid, tree),
+    _buckets_needing_resync_oid(oid, "6.1.4"),
+    _buckets_resynchronized_oid(oid, "6.1.5"),
+    _bucket_entries_resynchronized_oid(oid, "7.1.5"),
+    _bucket_data_resynchronized_oid(oid, "7.1.6"),
+    _bucket_data_resynchronized64_oid(oid, "7.1.7"),
+    _bucket_bandwidth_oid(oid, "8.1.6")
+  {
+    // The connection stats are the connection and bucket tables (astaire
+    // 6-8).
+    _subtrees.clear();
+    for (int table = 6; table <= 8; table++)
+    {
+      _subtrees.push_back(OID(oid, table));
+    }
+  };
+
+  u_char asn_type(OID oid)
+  {
+    return (_bucket_data_resynchronized64_oid.subtree_contains(oid)) ?
+                                                ASN_COUNTER64 : ASN_UNSIGNED;
+  }
+
+  // Each publish contains every connection and bucket, but usually only a
+  // few counters have changed.  Rather than rebuilding the tables, compare
+  // the publish against the rows from the previous publish as we parse it,
+  // and only apply the changed cells to the tree.
+  void handle(std::vector<std::string> msgs)
+  {
+    OIDMap sets;
+    std::vector<OID> removes;
+
+    for (int ii = 2; ii < (int)msgs.size(); )
+    {
+      // Check that we have enough fields for at least one connection.
+      if ((int)msgs.size() >= ii + 5)
+      {
+        // Connections are indexed by internet address and port (first two fields).
+        OIDInetAddr oid_addr(msgs[ii].c_str());
+        StatValue port;
+        StatValue num_buckets;
+        if (!oid_addr.isValid())
+        {
+          snmp_log(LOG_INFO, "AstaireConnectionStatHandler received invalid IP address - %s", msgs[ii].c_str());
+          break;
+        }
+        else if ((!parse_field(msgs[ii + 1], port)) ||
+                 (!parse_field(msgs[ii + 4], num_buckets)))
+        {
+          break;
+        }
+        else
+        {
+          ConnectionKey key(msgs[ii], port);
+          Connections::iterator conn = _connections.find(key);
+          if (conn == _connections.end())
+          {
+            // The index OID is only built when a connection first appears.
+            conn = _connections.insert(std::make_pair(key, ConnectionRow())).first;
+            conn->second.index = OID(oid_addr);
+            conn->second.index.append(port);
+          }
+
+          ConnectionRow& row = conn->second;
+          row.seen = true;
+          update_cell(row.buckets_needing_resync,
+                      parse_cell(msgs[ii + 2]),
+                      _buckets_needing_resync_oid,
+                      row.index,
+                      sets,
+                      removes);
+          update_cell(row.buckets_resynchronized,
+                      parse_cell(msgs[ii + 3]),
+                      _buckets_resynchronized_oid,
+                      row.index,
+                      sets,
+                      removes);
+
+          // Calculate the number of fields we expect from the number of
+          // buckets and keep parsing if we've got enough.
+          ii += 5;
+          if (num_buckets <= (StatValue)(msgs.size() - ii) / 4)
+          {
+            int end_buckets = ii + (int)num_buckets * 4;
+            for (; ii < end_buckets; ii += 4)
+            {
+              // Buckets are indexed by their identity (first field).
+              StatValue bucket_id;
+              if (!parse_field(msgs[ii], bucket_id))
+              {
+                continue;
+              }
+
+              update_bucket(row, bucket_id, msgs, ii + 1, sets, removes);
+            }
+          }
+          else
+          {
+            snmp_log(LOG_INFO, "AstaireConnectionStatHandler received too short bucket list - %d fields for %llu buckets", (int)msgs.size() - ii, (unsigned long long)num_buckets);
+            break;
+          }
+        }
+      }
+      else
+      {
+        snmp_log(LOG_INFO, "AstaireConnectionStatHandler received too short connection - %d < %d", (int)msgs.size(), ii + 4);
+        break;
+      }
+    }
+
+    remove_unseen_rows(sets, removes);
+
+    if ((!sets.empty()) || (!removes.empty()))
+    {
+      _tree->apply_changes(sets, removes);
+    }
+  }
+
+  // Rebuild the tables from the next publish, rather than trusting that the
+  // rows we last applied still match the tree.
+  void resync()
+  {
+    for (oid table = 6; table <= 8; table++)
+    {
+      _tree->remove_subtree(OID(_root_oid, table));
+    }
+    _connections.clear();
+  }
+
+private:
+  // A single table cell, which is absent if the connection or bucket doesn't
+  // exist or the field was malformed.
+  struct Cell
+  {
+    Cell() : present(false), value(0) {}
+    bool present;
+    StatValue value;
+
+    bool operator!=(const Cell& other) const
+    {
+      return ((present != other.present) ||
+              (present && (value != other.value)));
+    }
+  };
+
+  // The rows hold their index OIDs (built when the row is created) and
+  // whether they appeared in the publish being handled.
+  struct BucketRow
+  {
+    BucketRow() : seen(false) {}
+    Cell entries_resynchronized;
+    Cell data_resynchronized;
+    Cell bandwidth;
+    OID index;
+    OID bandwidth_index;
+    bool seen;
+  };
+  typedef std::map<StatValue, BucketRow> Buckets;
+
+  struct ConnectionRow
+  {
+    ConnectionRow() : seen(false) {}
+    Cell buckets_needing_resync;
+    Cell buckets_resynchronized;
+    Buckets buckets;
+    OID index;
+    bool seen;
+  };
+
+  // Connections are keyed on the address string and port from the publish.
+  typedef std::pair<std::string, StatValue> ConnectionKey;
+  typedef std::map<ConnectionKey, ConnectionRow> Connections;
+
+  Cell parse_cell(const std::string& field)
+  {
+    Cell cell;
+    cell.present = parse_field(field, cell.value);
+    return cell;
+  }
+
+  // Records a changed cell to apply to the tree.
+  void record_change(const Cell& current,
+                     const OID& column_oid,
+                     const OID& index,
+                     OIDMap& sets,
+                     std::vector<OID>& removes)
+  {
+    _cell_oid = column_oid;
+    _cell_oid.append(index.get_ptr(), index.get_len());
+
+    if (current.present)
+    {
+      sets[_cell_oid] = current.value;
+    }
+    else
+    {
+      removes.push_back(_cell_oid);
+    }
+  }
+
+  // Updates a cell we've stored, recording the change (if any) to apply to
+  // the tree.  The cell's OID is only built if the cell has changed.
+  void update_cell(Cell& stored,
+                   const Cell& current,
+                   const OID& column_oid,
+                   const OID& index,
+                   OIDMap& sets,
+                   std::vector<OID>& removes)
+  {
+    if (current != stored)
+    {
+      record_change(current, column_oid, index, sets, removes);
+      stored = current;
+    }
+  }
+
+  void update_bucket_cells(BucketRow& bucket,
+                           const Cell& entries_resynchronized,
+                           const Cell& data_resynchronized,
+                           const Cell& bandwidth,
+                           OIDMap& sets,
+                           std::vector<OID>& removes)
+  {
+    update_cell(bucket.entries_resynchronized,
+                entries_resynchronized,
+                _bucket_entries_resynchronized_oid,
+                bucket.index,
+                sets,
+                removes);
+
+    // The 32 and 64-bit data columns hold the same value.
+    if (data_resynchronized != bucket.data_resynchronized)
+    {
+      record_change(data_resynchronized,
+                    _bucket_data_resynchronized64_oid,
+                    bucket.index,
+                    sets,
+                    removes);
+    }
+    update_cell(bucket.data_resynchronized,
+                data_resynchronized,
+                _bucket_data_resynchronized_oid,
+                bucket.index,
+                sets,
+                removes);
+
+    update_cell(bucket.bandwidth,
+                bandwidth,
+                _bucket_bandwidth_oid,
+                bucket.bandwidth_index,
+                sets,
+                removes);
+  }
+
+  // Updates a bucket of a connection from the three fields of the publish
+  // following its identity.
+  void update_bucket(ConnectionRow& row,
+                     StatValue bucket_id,
+                     const std::vector<std::string>& msgs,
+                     int first_field,
+                     OIDMap& sets,
+                     std::vector<OID>& removes)
+  {
+    Buckets::iterator it = row.buckets.find(bucket_id);
+    if (it == row.buckets.end())
+    {
+      it = row.buckets.insert(std::make_pair(bucket_id, BucketRow())).first;
+      it->second.index = row.index;
+      it->second.index.append(bucket_id);
+
+      // The bandwidth table has an extra index for the scope.
+      it->second.bandwidth_index = it->second.index;
+      it->second.bandwidth_index.append(1);
+    }
+
+    it->second.seen = true;
+    update_bucket_cells(it->second,
+                        parse_cell(msgs[first_field]),
+                        parse_cell(msgs[first_field + 1]),
+                        parse_cell(msgs[first_field + 2]),
+                        sets,
+                        removes);
+  }
+
+  // Removes the cells of any connections and buckets that weren't in the
+  // publish, and clears the seen flags of the rest for the next publish.
+  void remove_unseen_rows(OIDMap& sets, std::vector<OID>& removes)
+  {
+    static const Cell NO_CELL;
+
+    for (Connections::iterator conn = _connections.begin();
+         conn != _connections.end(); )
+    {
+      ConnectionRow& row = conn->second;
+
+      for (Buckets::iterator it = row.buckets.begin();
+           it != row.buckets.end(); )
+      {
+        BucketRow& bucket = it->second;
+
+        if ((row.seen) && (bucket.seen))
+        {
+          bucket.seen = false;
+          ++it;
+        }
+        else
+        {
+          update_bucket_cells(bucket, NO_CELL, NO_CELL, NO_CELL, sets, removes);
+          it = row.buckets.erase(it);
+        }
+      }
+
+      if (row.seen)
+      {
+        row.seen = false;
+        ++conn;
+      }
+      else
+      {
+        update_cell(row.buckets_needing_resync,
+                    NO_CELL,
+                    _buckets_needing_resync_oid,
+                    row.index,
+                    sets,
+                    removes);
+        update_cell(row.buckets_resynchronized,
+                    NO_CELL,
+                    _buckets_resynchronized_oid,
+                    row.index,
+                    sets,
+                    removes);
+        conn = _connections.erase(conn);
+      }
+    }
+  }
+
+  // The column OIDs, to which the row indices are appended.
+  OID _buckets_needing_resync_oid;
+  OID _buckets_resynchronized_oid;
+  OID _bucket_entries_resynchronized_oid;
+  OID _bucket_data_resynchronized_oid;
+  OID _bucket_data_resynchronized64_oid;
+  OID _bucket_bandwidth_oid;
+
+  // Scratch buffer for building cell OIDs.
+  OID _cell_oid;
+
+  // The rows from the last publish, as applied to the tree.  These are
+  // updated in place as each publish is parsed.
+  Connections _connections;
+};
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// THIS FILE IS GENERATED BY mib-generator/cw_mib_generator.py FROM THE MIB
+// FRAGMENTS AND mib-generator/stats_plugins.json - DO NOT EDIT DIRECTLY!
+
+#ifndef ASTAIRE_STATS_HPP
+#define ASTAIRE_STATS_HPP
+
+#include "globals.hpp"
+#include "nodedata.hpp"
+#include "zmq_message_handler.hpp"
+
+// astaire
+static const oid astaire_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 9};
+
+static AstaireGlobalStatHandler astaire_global_handler(OID(astaire_oid, OID_LENGTH(astaire_oid)), &tree);
+static AstaireConnectionStatHandler astaire_connections_handler(OID(astaire_oid, OID_LENGTH(astaire_oid)), &tree);
+
+static NodeData astaire_node_data("astaire",
+                                  OID(astaire_oid, OID_LENGTH(astaire_oid)),
+                                  {"astaire_global",
+                                   "astaire_connections"},
+                                  {{"astaire_global", &astaire_global_handler},
+                                   {"astaire_connections", &astaire_connections_handler}},
+                                  NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+                                  true);
+
+#endif
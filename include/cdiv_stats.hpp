@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// THIS FILE IS GENERATED BY mib-generator/cw_mib_generator.py FROM THE MIB
+// FRAGMENTS AND mib-generator/stats_plugins.json - DO NOT EDIT DIRECTLY!
+
+#ifndef CDIV_STATS_HPP
+#define CDIV_STATS_HPP
+
+#include "globals.hpp"
+#include "nodedata.hpp"
+#include "zmq_message_handler.hpp"
+
+// callDiversionAs
+static const oid call_diversion_as_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7};
+// cdivAsTotal
+static const oid cdiv_as_total_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 1, 1, 2};
+// cdivAsTotalRate
+static const oid cdiv_as_total_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 4, 1, 2};
+// cdivAsUnconditional
+static const oid cdiv_as_unconditional_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 1, 1, 3};
+// cdivAsUnconditionalRate
+static const oid cdiv_as_unconditional_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 4, 1, 3};
+// cdivAsBusy
+static const oid cdiv_as_busy_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 1, 1, 4};
+// cdivAsBusyRate
+static const oid cdiv_as_busy_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 4, 1, 4};
+// cdivAsNotRegistered
+static const oid cdiv_as_not_registered_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 1, 1, 5};
+// cdivAsNotRegisteredRate
+static const oid cdiv_as_not_registered_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 4, 1, 5};
+// cdivAsNoAnswer
+static const oid cdiv_as_no_answer_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 1, 1, 6};
+// cdivAsNoAnswerRate
+static const oid cdiv_as_no_answer_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 4, 1, 6};
+// cdivAsNotReachable
+static const oid cdiv_as_not_reachable_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 1, 1, 7};
+// cdivAsNotReachableRate
+static const oid cdiv_as_not_reachable_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 7, 4, 1, 7};
+
+static BareStatHandler cdiv_total_handler(OID(cdiv_as_total_oid, OID_LENGTH(cdiv_as_total_oid)),
+                                          &tree,
+                                          ZMQMessageHandler::DEFAULT_EXPIRY,
+                                          OID(cdiv_as_total_rate_oid, OID_LENGTH(cdiv_as_total_rate_oid)));
+static BareStatHandler cdiv_unconditional_handler(OID(cdiv_as_unconditional_oid, OID_LENGTH(cdiv_as_unconditional_oid)),
+                                                  &tree,
+                                                  ZMQMessageHandler::DEFAULT_EXPIRY,
+                                                  OID(cdiv_as_unconditional_rate_oid, OID_LENGTH(cdiv_as_unconditional_rate_oid)));
+static BareStatHandler cdiv_busy_handler(OID(cdiv_as_busy_oid, OID_LENGTH(cdiv_as_busy_oid)),
+                                         &tree,
+                                         ZMQMessageHandler::DEFAULT_EXPIRY,
+                                         OID(cdiv_as_busy_rate_oid, OID_LENGTH(cdiv_as_busy_rate_oid)));
+static BareStatHandler cdiv_not_registered_handler(OID(cdiv_as_not_registered_oid, OID_LENGTH(cdiv_as_not_registered_oid)),
+                                                   &tree,
+                                                   ZMQMessageHandler::DEFAULT_EXPIRY,
+                                                   OID(cdiv_as_not_registered_rate_oid, OID_LENGTH(cdiv_as_not_registered_rate_oid)));
+static BareStatHandler cdiv_no_answer_handler(OID(cdiv_as_no_answer_oid, OID_LENGTH(cdiv_as_no_answer_oid)),
+                                              &tree,
+                                              ZMQMessageHandler::DEFAULT_EXPIRY,
+                                              OID(cdiv_as_no_answer_rate_oid, OID_LENGTH(cdiv_as_no_answer_rate_oid)));
+static BareStatHandler cdiv_not_reachable_handler(OID(cdiv_as_not_reachable_oid, OID_LENGTH(cdiv_as_not_reachable_oid)),
+                                                  &tree,
+                                                  ZMQMessageHandler::DEFAULT_EXPIRY,
+                                                  OID(cdiv_as_not_reachable_rate_oid, OID_LENGTH(cdiv_as_not_reachable_rate_oid)));
+
+static NodeData cdiv_node_data("sprout",
+                               OID(call_diversion_as_oid, OID_LENGTH(call_diversion_as_oid)),
+                               {"cdiv_total",
+                                "cdiv_unconditional",
+                                "cdiv_busy",
+                                "cdiv_not_registered",
+                                "cdiv_no_answer",
+                                "cdiv_not_reachable"},
+                               {{"cdiv_total", &cdiv_total_handler},
+                                {"cdiv_unconditional", &cdiv_unconditional_handler},
+                                {"cdiv_busy", &cdiv_busy_handler},
+                                {"cdiv_not_registered", &cdiv_not_registered_handler},
+                                {"cdiv_no_answer", &cdiv_no_answer_handler},
+                                {"cdiv_not_reachable", &cdiv_not_reachable_handler}},
+                               NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+                               false);
+
+#endif
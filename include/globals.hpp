@@ -10,10 +10,8 @@
 #ifndef GLOBALS_HPP
 #define GLOBALS_HPP
 
-#include <atomic>
 #include "oidtree.hpp"
 
 extern OIDTree tree;
-extern std::atomic_long last_seen_time;
 
 #endif /** BONOLATENCYTABLE_H */
@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// THIS FILE IS GENERATED BY mib-generator/cw_mib_generator.py FROM THE MIB
+// FRAGMENTS AND mib-generator/stats_plugins.json - DO NOT EDIT DIRECTLY!
+
+#ifndef MEMENTO_AS_STATS_HPP
+#define MEMENTO_AS_STATS_HPP
+
+#include "globals.hpp"
+#include "nodedata.hpp"
+#include "zmq_message_handler.hpp"
+
+// mementoSIP
+static const oid memento_sip_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 1};
+// mementoCompletedCallsRecorded
+static const oid memento_completed_calls_recorded_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 1, 1, 1, 2};
+// mementoFailedCallsRecorded
+static const oid memento_failed_calls_recorded_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 1, 1, 1, 3};
+// mementoCallsNotRecordedDueToOverload
+static const oid memento_calls_not_recorded_due_to_overload_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 1, 1, 1, 4};
+// mementoSIPCassandraReadLatencyTable
+static const oid memento_sip_cassandra_read_latency_table_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 1, 2};
+// mementoSIPCassandraWriteLatencyTable
+static const oid memento_sip_cassandra_write_latency_table_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 1, 3};
+
+static BareStatHandler memento_completed_calls_handler(OID(memento_completed_calls_recorded_oid, OID_LENGTH(memento_completed_calls_recorded_oid)), &tree);
+static BareStatHandler memento_failed_calls_handler(OID(memento_failed_calls_recorded_oid, OID_LENGTH(memento_failed_calls_recorded_oid)), &tree);
+static BareStatHandler memento_not_recorded_overload_handler(OID(memento_calls_not_recorded_due_to_overload_oid, OID_LENGTH(memento_calls_not_recorded_due_to_overload_oid)), &tree);
+// memento_cassandra_read_latency column 2: mementoSIPCassandraReadLatencyAverage
+// memento_cassandra_read_latency column 3: mementoSIPCassandraReadLatencyVariance
+// memento_cassandra_read_latency column 4: mementoSIPCassandraReadLatencyHWM
+// memento_cassandra_read_latency column 5: mementoSIPCassandraReadLatencyLWM
+// memento_cassandra_read_latency column 6: mementoSIPCassandraReadLatencyCount
+// memento_cassandra_read_latency column 7: mementoSIPCassandraReadLatencyRolling5MinAverage
+// memento_cassandra_read_latency column 8: mementoSIPCassandraReadLatencyRolling5MinVariance
+// memento_cassandra_read_latency column 9: mementoSIPCassandraReadLatencyRolling5MinHWM
+// memento_cassandra_read_latency column 10: mementoSIPCassandraReadLatencyRolling5MinLWM
+// memento_cassandra_read_latency column 11: mementoSIPCassandraReadLatencyRolling5MinCount
+// memento_cassandra_read_latency column 12: mementoSIPCassandraReadLatencyRolling15MinAverage
+// memento_cassandra_read_latency column 13: mementoSIPCassandraReadLatencyRolling15MinVariance
+// memento_cassandra_read_latency column 14: mementoSIPCassandraReadLatencyRolling15MinHWM
+// memento_cassandra_read_latency column 15: mementoSIPCassandraReadLatencyRolling15MinLWM
+// memento_cassandra_read_latency column 16: mementoSIPCassandraReadLatencyRolling15MinCount
+// memento_cassandra_read_latency column 17: mementoSIPCassandraReadLatencyRolling60MinAverage
+// memento_cassandra_read_latency column 18: mementoSIPCassandraReadLatencyRolling60MinVariance
+// memento_cassandra_read_latency column 19: mementoSIPCassandraReadLatencyRolling60MinHWM
+// memento_cassandra_read_latency column 20: mementoSIPCassandraReadLatencyRolling60MinLWM
+// memento_cassandra_read_latency column 21: mementoSIPCassandraReadLatencyRolling60MinCount
+static AccumulatedWithCountStatHandler memento_cassandra_read_latency_handler(OID(memento_sip_cassandra_read_latency_table_oid, OID_LENGTH(memento_sip_cassandra_read_latency_table_oid)), &tree);
+// memento_cassandra_write_latency column 2: mementoSIPCassandraWriteLatencyAverage
+// memento_cassandra_write_latency column 3: mementoSIPCassandraWriteLatencyVariance
+// memento_cassandra_write_latency column 4: mementoSIPCassandraWriteLatencyHWM
+// memento_cassandra_write_latency column 5: mementoSIPCassandraWriteLatencyLWM
+// memento_cassandra_write_latency column 6: mementoSIPCassandraWriteLatencyCount
+// memento_cassandra_write_latency column 7: mementoSIPCassandraWriteLatencyRolling5MinAverage
+// memento_cassandra_write_latency column 8: mementoSIPCassandraWriteLatencyRolling5MinVariance
+// memento_cassandra_write_latency column 9: mementoSIPCassandraWriteLatencyRolling5MinHWM
+// memento_cassandra_write_latency column 10: mementoSIPCassandraWriteLatencyRolling5MinLWM
+// memento_cassandra_write_latency column 11: mementoSIPCassandraWriteLatencyRolling5MinCount
+// memento_cassandra_write_latency column 12: mementoSIPCassandraWriteLatencyRolling15MinAverage
+// memento_cassandra_write_latency column 13: mementoSIPCassandraWriteLatencyRolling15MinVariance
+// memento_cassandra_write_latency column 14: mementoSIPCassandraWriteLatencyRolling15MinHWM
+// memento_cassandra_write_latency column 15: mementoSIPCassandraWriteLatencyRolling15MinLWM
+// memento_cassandra_write_latency column 16: mementoSIPCassandraWriteLatencyRolling15MinCount
+// memento_cassandra_write_latency column 17: mementoSIPCassandraWriteLatencyRolling60MinAverage
+// memento_cassandra_write_latency column 18: mementoSIPCassandraWriteLatencyRolling60MinVariance
+// memento_cassandra_write_latency column 19: mementoSIPCassandraWriteLatencyRolling60MinHWM
+// memento_cassandra_write_latency column 20: mementoSIPCassandraWriteLatencyRolling60MinLWM
+// memento_cassandra_write_latency column 21: mementoSIPCassandraWriteLatencyRolling60MinCount
+static AccumulatedWithCountStatHandler memento_cassandra_write_latency_handler(OID(memento_sip_cassandra_write_latency_table_oid, OID_LENGTH(memento_sip_cassandra_write_latency_table_oid)), &tree);
+
+static NodeData memento_as_node_data("sprout",
+                                     OID(memento_sip_oid, OID_LENGTH(memento_sip_oid)),
+                                     {"memento_completed_calls",
+                                      "memento_failed_calls",
+                                      "memento_not_recorded_overload",
+                                      "memento_cassandra_read_latency",
+                                      "memento_cassandra_write_latency"},
+                                     {{"memento_completed_calls", &memento_completed_calls_handler},
+                                      {"memento_failed_calls", &memento_failed_calls_handler},
+                                      {"memento_not_recorded_overload", &memento_not_recorded_overload_handler},
+                                      {"memento_cassandra_read_latency", &memento_cassandra_read_latency_handler},
+                                      {"memento_cassandra_write_latency", &memento_cassandra_write_latency_handler}},
+                                     NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+                                     false);
+
+#endif
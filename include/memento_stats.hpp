@@ -0,0 +1,207 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// THIS FILE IS GENERATED BY mib-generator/cw_mib_generator.py FROM THE MIB
+// FRAGMENTS AND mib-generator/stats_plugins.json - DO NOT EDIT DIRECTLY!
+
+#ifndef MEMENTO_STATS_HPP
+#define MEMENTO_STATS_HPP
+
+#include "globals.hpp"
+#include "nodedata.hpp"
+#include "zmq_message_handler.hpp"
+
+// mementoHTTP
+static const oid memento_http_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2};
+// mementoHTTPRequestCount
+static const oid memento_http_request_count_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 1, 1, 2};
+// mementoHTTPRequestRate
+static const oid memento_http_request_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 6, 1, 2};
+// mementoHTTPRejectedDueToOverload
+static const oid memento_http_rejected_due_to_overload_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 1, 1, 3};
+// mementoHTTPRejectedDueToOverloadRate
+static const oid memento_http_rejected_due_to_overload_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 6, 1, 3};
+// mementoHTTPRequestLatencyTable
+static const oid memento_http_request_latency_table_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 2};
+// mementoHTTPCassandraReadLatencyTable
+static const oid memento_http_cassandra_read_latency_table_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 3};
+// mementoRetrievedCallRecordSizeTable
+static const oid memento_retrieved_call_record_size_table_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 4};
+// mementoRetrievedCallRecordLengthTable
+static const oid memento_retrieved_call_record_length_table_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 2, 5};
+// mementoAuthProxy
+static const oid memento_auth_proxy_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3};
+// mementoAuthChallengeCount
+static const oid memento_auth_challenge_count_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 2, 1, 2};
+// mementoAuthChallengeRate
+static const oid memento_auth_challenge_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 3, 1, 2};
+// mementoAuthAttemptCount
+static const oid memento_auth_attempt_count_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 2, 1, 3};
+// mementoAuthAttemptRate
+static const oid memento_auth_attempt_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 3, 1, 3};
+// mementoAuthSuccessCount
+static const oid memento_auth_success_count_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 2, 1, 4};
+// mementoAuthSuccessRate
+static const oid memento_auth_success_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 3, 1, 4};
+// mementoAuthFailureCount
+static const oid memento_auth_failure_count_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 2, 1, 5};
+// mementoAuthFailureRate
+static const oid memento_auth_failure_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 3, 1, 5};
+// mementoAuthStaleCount
+static const oid memento_auth_stale_count_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 2, 1, 6};
+// mementoAuthStaleRate
+static const oid memento_auth_stale_rate_oid[] = {1, 2, 826, 0, 1, 1578918, 9, 8, 3, 3, 1, 6};
+
+static BareStatHandler http_incoming_requests_handler(OID(memento_http_request_count_oid, OID_LENGTH(memento_http_request_count_oid)),
+                                                      &tree,
+                                                      ZMQMessageHandler::DEFAULT_EXPIRY,
+                                                      OID(memento_http_request_rate_oid, OID_LENGTH(memento_http_request_rate_oid)));
+static BareStatHandler http_rejected_overload_handler(OID(memento_http_rejected_due_to_overload_oid, OID_LENGTH(memento_http_rejected_due_to_overload_oid)),
+                                                      &tree,
+                                                      ZMQMessageHandler::DEFAULT_EXPIRY,
+                                                      OID(memento_http_rejected_due_to_overload_rate_oid, OID_LENGTH(memento_http_rejected_due_to_overload_rate_oid)));
+// http_latency_us column 2: mementoHTTPRequestLatencyAverage
+// http_latency_us column 3: mementoHTTPRequestLatencyVariance
+// http_latency_us column 4: mementoHTTPRequestLatencyHWM
+// http_latency_us column 5: mementoHTTPRequestLatencyLWM
+// http_latency_us column 6: mementoHTTPRequestLatencyCount
+// http_latency_us column 7: mementoHTTPRequestLatencyRolling5MinAverage
+// http_latency_us column 8: mementoHTTPRequestLatencyRolling5MinVariance
+// http_latency_us column 9: mementoHTTPRequestLatencyRolling5MinHWM
+// http_latency_us column 10: mementoHTTPRequestLatencyRolling5MinLWM
+// http_latency_us column 11: mementoHTTPRequestLatencyRolling5MinCount
+// http_latency_us column 12: mementoHTTPRequestLatencyRolling15MinAverage
+// http_latency_us column 13: mementoHTTPRequestLatencyRolling15MinVariance
+// http_latency_us column 14: mementoHTTPRequestLatencyRolling15MinHWM
+// http_latency_us column 15: mementoHTTPRequestLatencyRolling15MinLWM
+// http_latency_us column 16: mementoHTTPRequestLatencyRolling15MinCount
+// http_latency_us column 17: mementoHTTPRequestLatencyRolling60MinAverage
+// http_latency_us column 18: mementoHTTPRequestLatencyRolling60MinVariance
+// http_latency_us column 19: mementoHTTPRequestLatencyRolling60MinHWM
+// http_latency_us column 20: mementoHTTPRequestLatencyRolling60MinLWM
+// http_latency_us column 21: mementoHTTPRequestLatencyRolling60MinCount
+static AccumulatedWithCountStatHandler http_latency_us_handler(OID(memento_http_request_latency_table_oid, OID_LENGTH(memento_http_request_latency_table_oid)), &tree);
+// cassandra_read_latency column 2: mementoHTTPCassandraReadLatencyAverage
+// cassandra_read_latency column 3: mementoHTTPCassandraReadLatencyVariance
+// cassandra_read_latency column 4: mementoHTTPCassandraReadLatencyHWM
+// cassandra_read_latency column 5: mementoHTTPCassandraReadLatencyLWM
+// cassandra_read_latency column 6: mementoHTTPCassandraReadLatencyCount
+// cassandra_read_latency column 7: mementoHTTPCassandraReadLatencyRolling5MinAverage
+// cassandra_read_latency column 8: mementoHTTPCassandraReadLatencyRolling5MinVariance
+// cassandra_read_latency column 9: mementoHTTPCassandraReadLatencyRolling5MinHWM
+// cassandra_read_latency column 10: mementoHTTPCassandraReadLatencyRolling5MinLWM
+// cassandra_read_latency column 11: mementoHTTPCassandraReadLatencyRolling5MinCount
+// cassandra_read_latency column 12: mementoHTTPCassandraReadLatencyRolling15MinAverage
+// cassandra_read_latency column 13: mementoHTTPCassandraReadLatencyRolling15MinVariance
+// cassandra_read_latency column 14: mementoHTTPCassandraReadLatencyRolling15MinHWM
+// cassandra_read_latency column 15: mementoHTTPCassandraReadLatencyRolling15MinLWM
+// cassandra_read_latency column 16: mementoHTTPCassandraReadLatencyRolling15MinCount
+// cassandra_read_latency column 17: mementoHTTPCassandraReadLatencyRolling60MinAverage
+// cassandra_read_latency column 18: mementoHTTPCassandraReadLatencyRolling60MinVariance
+// cassandra_read_latency column 19: mementoHTTPCassandraReadLatencyRolling60MinHWM
+// cassandra_read_latency column 20: mementoHTTPCassandraReadLatencyRolling60MinLWM
+// cassandra_read_latency column 21: mementoHTTPCassandraReadLatencyRolling60MinCount
+static AccumulatedWithCountStatHandler cassandra_read_latency_handler(OID(memento_http_cassandra_read_latency_table_oid, OID_LENGTH(memento_http_cassandra_read_latency_table_oid)), &tree);
+// record_size column 2: mementoRetrievedCallRecordSizeAverage
+// record_size column 3: mementoRetrievedCallRecordSizeVariance
+// record_size column 4: mementoRetrievedCallRecordSizeHWM
+// record_size column 5: mementoRetrievedCallRecordSizeLWM
+// record_size column 6: mementoRetrievedCallRecordSizeCount
+// record_size column 7: mementoRetrievedCallRecordSizeRolling5MinAverage
+// record_size column 8: mementoRetrievedCallRecordSizeRolling5MinVariance
+// record_size column 9: mementoRetrievedCallRecordSizeRolling5MinHWM
+// record_size column 10: mementoRetrievedCallRecordSizeRolling5MinLWM
+// record_size column 11: mementoRetrievedCallRecordSizeRolling5MinCount
+// record_size column 12: mementoRetrievedCallRecordSizeRolling15MinAverage
+// record_size column 13: mementoRetrievedCallRecordSizeRolling15MinVariance
+// record_size column 14: mementoRetrievedCallRecordSizeRolling15MinHWM
+// record_size column 15: mementoRetrievedCallRecordSizeRolling15MinLWM
+// record_size column 16: mementoRetrievedCallRecordSizeRolling15MinCount
+// record_size column 17: mementoRetrievedCallRecordSizeRolling60MinAverage
+// record_size column 18: mementoRetrievedCallRecordSizeRolling60MinVariance
+// record_size column 19: mementoRetrievedCallRecordSizeRolling60MinHWM
+// record_size column 20: mementoRetrievedCallRecordSizeRolling60MinLWM
+// record_size column 21: mementoRetrievedCallRecordSizeRolling60MinCount
+static AccumulatedWithCountStatHandler record_size_handler(OID(memento_retrieved_call_record_size_table_oid, OID_LENGTH(memento_retrieved_call_record_size_table_oid)), &tree);
+// record_length column 2: mementoRetrievedCallRecordLengthAverage
+// record_length column 3: mementoRetrievedCallRecordLengthVariance
+// record_length column 4: mementoRetrievedCallRecordLengthHWM
+// record_length column 5: mementoRetrievedCallRecordLengthLWM
+// record_length column 6: mementoRetrievedCallRecordLengthCount
+// record_length column 7: mementoRetrievedCallRecordLengthRolling5MinAverage
+// record_length column 8: mementoRetrievedCallRecordLengthRolling5MinVariance
+// record_length column 9: mementoRetrievedCallRecordLengthRolling5MinHWM
+// record_length column 10: mementoRetrievedCallRecordLengthRolling5MinLWM
+// record_length column 11: mementoRetrievedCallRecordLengthRolling5MinCount
+// record_length column 12: mementoRetrievedCallRecordLengthRolling15MinAverage
+// record_length column 13: mementoRetrievedCallRecordLengthRolling15MinVariance
+// record_length column 14: mementoRetrievedCallRecordLengthRolling15MinHWM
+// record_length column 15: mementoRetrievedCallRecordLengthRolling15MinLWM
+// record_length column 16: mementoRetrievedCallRecordLengthRolling15MinCount
+// record_length column 17: mementoRetrievedCallRecordLengthRolling60MinAverage
+// record_length column 18: mementoRetrievedCallRecordLengthRolling60MinVariance
+// record_length column 19: mementoRetrievedCallRecordLengthRolling60MinHWM
+// record_length column 20: mementoRetrievedCallRecordLengthRolling60MinLWM
+// record_length column 21: mementoRetrievedCallRecordLengthRolling60MinCount
+static AccumulatedWithCountStatHandler record_length_handler(OID(memento_retrieved_call_record_length_table_oid, OID_LENGTH(memento_retrieved_call_record_length_table_oid)), &tree);
+
+static NodeData memento_http_node_data("memento",
+                                       OID(memento_http_oid, OID_LENGTH(memento_http_oid)),
+                                       {"http_incoming_requests",
+                                        "http_rejected_overload",
+                                        "http_latency_us",
+                                        "cassandra_read_latency",
+                                        "record_size",
+                                        "record_length"},
+                                       {{"http_incoming_requests", &http_incoming_requests_handler},
+                                        {"http_rejected_overload", &http_rejected_overload_handler},
+                                        {"http_latency_us", &http_latency_us_handler},
+                                        {"cassandra_read_latency", &cassandra_read_latency_handler},
+                                        {"record_size", &record_size_handler},
+                                        {"record_length", &record_length_handler}},
+                                       NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+                                       false);
+
+static BareStatHandler auth_challenges_handler(OID(memento_auth_challenge_count_oid, OID_LENGTH(memento_auth_challenge_count_oid)),
+                                               &tree,
+                                               ZMQMessageHandler::DEFAULT_EXPIRY,
+                                               OID(memento_auth_challenge_rate_oid, OID_LENGTH(memento_auth_challenge_rate_oid)));
+static BareStatHandler auth_attempts_handler(OID(memento_auth_attempt_count_oid, OID_LENGTH(memento_auth_attempt_count_oid)),
+                                             &tree,
+                                             ZMQMessageHandler::DEFAULT_EXPIRY,
+                                             OID(memento_auth_attempt_rate_oid, OID_LENGTH(memento_auth_attempt_rate_oid)));
+static BareStatHandler auth_successes_handler(OID(memento_auth_success_count_oid, OID_LENGTH(memento_auth_success_count_oid)),
+                                              &tree,
+                                              ZMQMessageHandler::DEFAULT_EXPIRY,
+                                              OID(memento_auth_success_rate_oid, OID_LENGTH(memento_auth_success_rate_oid)));
+static BareStatHandler auth_failures_handler(OID(memento_auth_failure_count_oid, OID_LENGTH(memento_auth_failure_count_oid)),
+                                             &tree,
+                                             ZMQMessageHandler::DEFAULT_EXPIRY,
+                                             OID(memento_auth_failure_rate_oid, OID_LENGTH(memento_auth_failure_rate_oid)));
+static BareStatHandler auth_stales_handler(OID(memento_auth_stale_count_oid, OID_LENGTH(memento_auth_stale_count_oid)),
+                                           &tree,
+                                           ZMQMessageHandler::DEFAULT_EXPIRY,
+                                           OID(memento_auth_stale_rate_oid, OID_LENGTH(memento_auth_stale_rate_oid)));
+
+static NodeData memento_auth_node_data("memento",
+                                       OID(memento_auth_proxy_oid, OID_LENGTH(memento_auth_proxy_oid)),
+                                       {"auth_challenges",
+                                        "auth_attempts",
+                                        "auth_successes",
+                                        "auth_failures",
+                                        "auth_stales"},
+                                       {{"auth_challenges", &auth_challenges_handler},
+                                        {"auth_attempts", &auth_attempts_handler},
+                                        {"auth_successes", &auth_successes_handler},
+                                        {"auth_failures", &auth_failures_handler},
+                                        {"auth_stales", &auth_stales_handler}},
+                                       NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+                                       false);
+
+#endif
@@ -15,24 +15,129 @@
 #include <string>
 #include "oid.hpp"
 #include "zmq_message_handler.hpp"
+#include "stats_shm.hpp"
 
 class NodeData
 {
 public:
+  // Number of seconds a stat can go without being polled before we drop our
+  // subscription to it. Zero means always stay subscribed.
+  const static int DEFAULT_IDLE_UNSUBSCRIBE_TIME = 3600;
+
   NodeData(std::string _name,
            OID _root_oid,
            std::vector<std::string> _stats,
-           std::map<std::string, ZMQMessageHandler*> _stat_to_handler) :
+           std::map<std::string, ZMQMessageHandler*> _stat_to_handler,
+           int _idle_unsubscribe_time = DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+           bool _lazy_parse = false,
+           bool _shm_transport = false) :
     name(_name),
     root_oid(_root_oid),
     stats(_stats),
-    stat_to_handler(_stat_to_handler)
+    stat_to_handler(_stat_to_handler),
+    idle_unsubscribe_time(_idle_unsubscribe_time),
+    lazy_parse(_lazy_parse),
+    shm_transport(_shm_transport),
+    shm_reader(NULL)
   {}
 
+  // Returns the handler for the stat whose subtree contains the given OID,
+  // or NULL if no registered stat owns it.
+  ZMQMessageHandler* handler_for_oid(OID oid)
+  {
+    for (std::map<std::string, ZMQMessageHandler*>::iterator it = stat_to_handler.begin();
+         it != stat_to_handler.end();
+         it++)
+    {
+      if (it->second->owns(oid))
+      {
+        return it->second;
+      }
+    }
+    return NULL;
+  }
+
+  // Applies the stored publishes of any stats that could hold entries
+  // following the given OID, up to and including the limit OID (or anywhere
+  // after it, if there's no limit).  Returns whether any were applied.
+  bool materialize_after(OID oid, const OID* limit)
+  {
+    bool materialized = false;
+
+    for (std::map<std::string, ZMQMessageHandler*>::iterator it = stat_to_handler.begin();
+         it != stat_to_handler.end();
+         it++)
+    {
+      ZMQMessageHandler* handler = it->second;
+      if ((handler->has_pending()) && (handler->owns_after(oid, limit)))
+      {
+        handler->materialize();
+        materialized = true;
+      }
+    }
+
+    return materialized;
+  }
+
+  // Finds the entry following the given OID for a GETNEXT, skipping any
+  // belonging to stats that have gone stale.  Returns false if there isn't
+  // one, or the entry and the handler owning it (or NULL) if there is.
+  bool get_next(OIDTree& tree,
+                OID oid,
+                long now,
+                OID& next_oid,
+                StatValue& value,
+                ZMQMessageHandler*& handler)
+  {
+    while (1)
+    {
+      bool found = tree.get_next(oid, next_oid, value);
+
+      // Only parse the stored publishes of the stats that could hold the
+      // next entry, i.e. those with entries between this OID and the entry
+      // we've found.  Parsing them may change which entry comes next, so
+      // check again until there's nothing more to parse.
+      while ((lazy_parse) &&
+             (materialize_after(oid, found ? &next_oid : NULL)))
+      {
+        found = tree.get_next(oid, next_oid, value);
+      }
+
+      if (!found)
+      {
+        return false;
+      }
+
+      handler = handler_for_oid(next_oid);
+      if (handler != NULL)
+      {
+        handler->record_access(now);
+      }
+
+      if ((handler == NULL) || (handler->is_fresh(now)))
+      {
+        return true;
+      }
+
+      oid = next_oid;
+    }
+  }
+
   std::string name;
   OID root_oid;
   std::vector<std::string> stats;
   std::map<std::string, ZMQMessageHandler*> stat_to_handler;
+  int idle_unsubscribe_time;
+
+  // If set, publishes are only stored by the listener, and are parsed the
+  // first time an SNMP request needs them.  This doesn't apply to stats
+  // whose handlers keep history, which are always parsed on arrival.
+  bool lazy_parse;
+
+  // If set, the stats are read from the component's shared memory file at
+  // request time (through shm_reader), rather than subscribed to over ZMQ.
+  bool shm_transport;
+  StatsShmReader* shm_reader;
 };
 
 #endif
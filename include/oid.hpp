@@ -29,8 +29,8 @@ public:
   OID() {};
   OID(oid);
   OID(OID, oid);
-  OID(oid*, int);
-  OID(OID, oid*, int);
+  OID(const oid*, int);
+  OID(OID, const oid*, int);
   OID(std::string);
   OID(OID, std::string);
   OID(OIDInetAddr);
@@ -42,9 +42,10 @@ public:
   const oid* get_ptr() const;
   int get_len() const;
   void append(oid);
-  void append(oid*, int);
+  void append(const oid*, int);
   void append(std::string);
   void append(OIDInetAddr);
+  void truncate(int);
   std::string to_string() const;
   void dump() const;
 private:
@@ -12,8 +12,10 @@
 #define OIDTREE_HPP
 
 #include "oid.hpp"
+#include "stat_value.hpp"
 #include <map>
 #include <mutex>
+#include <vector>
 
 class OIDCompare
 {
@@ -25,23 +27,46 @@ public:
   }
 };
 
-typedef std::map<OID, int, OIDCompare> OIDMap;
+typedef std::map<OID, StatValue, OIDCompare> OIDMap;
 
 
+// The tree of stats values, split into shards by component (the first
+// SHARD_DEPTH elements of the OID, e.g. ...1578918.9.8 for Memento), each
+// with its own lock.  All the plugins loaded in a process share one tree, so
+// this stops a busy component's updates from blocking reads of the others.
 class OIDTree
 {
 public:
-  bool get(OID, int&);
-  bool get_next(OID, OID&, int&);
-  void set(OID, int);
+  enum {SHARD_DEPTH = 8};
+
+  ~OIDTree();
+
+  bool get(OID, StatValue&);
+  bool get_next(OID, OID&, StatValue&);
+  void set(OID, StatValue);
   void remove(OID);
   void remove_subtree(OID);
-  void replace_subtree(OID, OIDMap);
+  void replace_subtree(OID, const OIDMap&);
+  void apply_changes(const OIDMap&, const std::vector<OID>&);
   void dump();
 
 private:
-  OIDMap _oidmap;
-  std::recursive_mutex _map_lock;
+  struct Shard
+  {
+    OIDMap oidmap;
+    std::recursive_mutex lock;
+  };
+  typedef std::map<OID, Shard*, OIDCompare> ShardMap;
+
+  static OID shard_key(const OID&);
+  Shard* get_shard(const OID&, bool create);
+  void remove_subtree_from_shard(Shard*, OID);
+
+  // Shards are created on demand but never destroyed, so a pointer to one
+  // stays valid once it's been looked up.  The shard lock must not be held
+  // while taking _shards_lock.
+  ShardMap _shards;
+  std::mutex _shards_lock;
 };
 
 #endif
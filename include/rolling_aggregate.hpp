@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef ROLLING_AGGREGATE_HPP
+#define ROLLING_AGGREGATE_HPP
+
+#include "stat_value.hpp"
+
+// Combines successive publishes of an accumulated stat (average, variance,
+// HWM, LWM and count over a period) into aggregates over the last 5, 15 and
+// 60 minutes.
+//
+// Publishes are folded into one bucket per minute, and a window's aggregate
+// is built from the buckets it covers, so the memory used is fixed however
+// often the stat is published.
+class RollingAggregate
+{
+public:
+  enum {NUM_WINDOWS = 3};
+
+  // The window lengths, in minutes.
+  static const int WINDOWS[NUM_WINDOWS];
+
+  struct Aggregate
+  {
+    StatValue average;
+    StatValue variance;
+    StatValue hwm;
+    StatValue lwm;
+    StatValue count;
+  };
+
+  RollingAggregate();
+
+  // Records a publish at the given time.
+  void add_sample(long now,
+                  StatValue average,
+                  StatValue variance,
+                  StatValue hwm,
+                  StatValue lwm,
+                  StatValue count);
+
+  // The aggregate over the window with the given position in WINDOWS.
+  Aggregate aggregate(int window) const;
+
+  // Throws away all the publishes, e.g. because some have been missed.
+  void reset();
+
+private:
+  enum {NUM_BUCKETS = 60};
+
+  struct Bucket
+  {
+    long minute;
+    StatValue count;
+
+    // The sums of the values and of their squares, from which the mean and
+    // variance across publishes can be calculated.
+    double sum;
+    double sum_of_squares;
+    StatValue hwm;
+    StatValue lwm;
+  };
+
+  Bucket _buckets[NUM_BUCKETS];
+
+  // The minute of the latest publish.
+  long _current_minute;
+};
+
+#endif
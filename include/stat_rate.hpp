@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef STAT_RATE_HPP
+#define STAT_RATE_HPP
+
+#include <vector>
+#include "stat_value.hpp"
+
+// Calculates the average rate of a counter stat over a set of windows (e.g.
+// the last minute and last five minutes) from successive publishes.  Each
+// publish is the count for one period (e.g. scopePrevious5SecondPeriod), so
+// the rate over a window is the sum of the counts published within it,
+// divided by its length.
+//
+// The samples are held in a fixed-size ring, and a running sum is kept per
+// window, so adding a sample and reading the rates is cheap however many
+// publishes each window covers.
+class StatRate
+{
+public:
+  // Enough for a five minute window of publishes every second.
+  enum {MAX_SAMPLES = 300};
+
+  StatRate(const std::vector<int>& windows);
+
+  // The window lengths, in seconds.
+  const std::vector<int>& windows() const { return _windows; }
+
+  // Records a publish of the given count at the given time.
+  void add_sample(long now, StatValue count);
+
+  // Throws away all the samples, e.g. because publishes have been missed.
+  void reset();
+
+  // The average rate over the window with the given position in windows(),
+  // in thousandths of an event per second.
+  StatValue rate(size_t window) const;
+
+  // The windows used unless a stat is configured otherwise - one and five
+  // minutes.
+  static std::vector<int> default_windows();
+
+private:
+  struct Sample
+  {
+    long time;
+    StatValue count;
+  };
+
+  Sample _samples[MAX_SAMPLES];
+
+  // The next slot in the ring to write to, and the number of samples held.
+  size_t _head;
+  size_t _size;
+
+  std::vector<int> _windows;
+
+  // Per window, the sum of the counts of the samples within it, and the
+  // number of the most recent samples that make up that sum.
+  std::vector<StatValue> _sums;
+  std::vector<size_t> _counts;
+};
+
+#endif
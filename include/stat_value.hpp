@@ -0,0 +1,32 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef STAT_VALUE_HPP
+#define STAT_VALUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Stats values are held at 64 bits, as some counters (e.g. bytes
+// resynchronized) can pass 2^31.
+typedef uint64_t StatValue;
+
+// Decodes an unsigned decimal stat value from the len characters at start.
+// The field doesn't need to be NUL-terminated. Returns false (leaving value
+// untouched) if the field is empty, contains anything other than digits or
+// doesn't fit in a StatValue.
+bool parse_stat_value(const char* start, size_t len, StatValue& value);
+
+inline bool parse_stat_value(const std::string& field, StatValue& value)
+{
+  return parse_stat_value(field.data(), field.size(), value);
+}
+
+#endif
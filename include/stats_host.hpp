@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef STATS_HOST_HPP
+#define STATS_HOST_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <pthread.h>
+#include "nodedata.hpp"
+#include "zmq_listener.hpp"
+
+// Hosts the ZMQ listeners for every stats plugin loaded into the process.
+// The plugins all link against the same shared library, so they share this
+// one instance - a single ZMQ context and a single thread polling all of
+// their sockets, rather than a context and thread per plugin.
+class StatsHost
+{
+public:
+  static StatsHost* get_instance();
+
+  // Adds a plugin's node data.  Its listener is created the next time the
+  // host thread goes round its loop.
+  void add_node_data(NodeData* node_data);
+
+  // Starts the host thread, if it isn't already running.  This must be
+  // called after snmpd has daemonized (i.e. not from a plugin's init
+  // function), as the thread doesn't survive the fork.
+  void start();
+
+private:
+  // How often we check whether to drop or restore stat subscriptions (and
+  // pick up any newly added node data).
+  enum {POLL_INTERVAL_MS = 1000};
+
+  StatsHost() : _started(false) {}
+
+  static void* run_thread(void* host_ptr);
+  void run();
+  void create_listeners(void* ctx, std::vector<ZMQListener*>& listeners);
+
+  std::atomic_bool _started;
+  pthread_t _thread;
+
+  // Node data added since the host thread last created listeners.
+  std::vector<NodeData*> _pending;
+  std::mutex _pending_lock;
+};
+
+#endif
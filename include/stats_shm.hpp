@@ -0,0 +1,159 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef STATS_SHM_HPP
+#define STATS_SHM_HPP
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include <sys/types.h>
+#include "stat_value.hpp"
+#include "zmq_message_handler.hpp"
+
+// The layout of the memory-mapped file that a component can publish its stats
+// in, as an alternative to ZMQ.  The file for a component is
+// /var/run/clearwater/stats/<name>.shm (alongside its ZMQ socket).  The
+// publisher creates the directory if it doesn't exist, as /var/run is
+// emptied on reboot.
+//
+// The file is a header followed by a fixed array of slots, one per stat.  A
+// slot holds the same values as the fields following "OK" in a ZMQ publish,
+// as binary numbers.  Each slot is protected by a seqlock - the publisher
+// makes the sequence number odd while it updates the slot, and readers retry
+// if the sequence number was odd or changed while they copied the slot.
+//
+// The publisher owns the file.  If it restarts it creates a new file, which
+// readers notice and map in place of the old one.
+//
+// Stats are only read when an SNMP request needs them, so any publishes in
+// between are never seen.  This means the transport can't be used for stats
+// whose handlers keep history (such as rates).
+namespace StatsShm
+{
+  const uint32_t MAGIC = 0x43575353; // "CWSS"
+  const uint32_t VERSION = 1;
+
+  enum {MAX_STATS = 64, MAX_NAME_LEN = 64, MAX_VALUES = 64};
+
+  const char* const DEFAULT_DIRECTORY = "/var/run/clearwater/stats";
+
+  struct Slot
+  {
+    std::atomic<uint32_t> seq;
+    uint32_t num_values;
+    int64_t publish_time;
+    char name[MAX_NAME_LEN];
+    uint64_t values[MAX_VALUES];
+  };
+
+  struct Region
+  {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> num_slots;
+    uint32_t reserved;
+    Slot slots[MAX_STATS];
+  };
+
+  // The layout is shared with publishers built separately, so check that
+  // it's what we expect, and that the sequence numbers can be shared between
+  // processes.
+  static_assert(ATOMIC_INT_LOCK_FREE == 2,
+                "Stats seqlocks must be lock free");
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "Stats seqlocks must be plain 32-bit integers");
+  static_assert((offsetof(Slot, publish_time) == 8) &&
+                (offsetof(Slot, name) == 16) &&
+                (offsetof(Slot, values) == 16 + MAX_NAME_LEN) &&
+                (sizeof(Slot) == 16 + MAX_NAME_LEN + 8 * MAX_VALUES),
+                "StatsShm::Slot layout has changed");
+  static_assert((offsetof(Region, num_slots) == 8) &&
+                (offsetof(Region, slots) == 16) &&
+                (sizeof(Region) == 16 + MAX_STATS * sizeof(Slot)),
+                "StatsShm::Region layout has changed");
+
+  std::string path(const std::string& directory, const std::string& name);
+}
+
+// Publishes stats to a component's shared memory file.  This is what a
+// component's stats code does in place of a ZMQ publish.  It's used by the
+// stand-in publisher for testing.
+class StatsShmWriter
+{
+public:
+  StatsShmWriter(const std::string& name,
+                 const std::string& directory = StatsShm::DEFAULT_DIRECTORY) :
+    _name(name),
+    _directory(directory),
+    _region(NULL)
+  {}
+  ~StatsShmWriter();
+
+  bool open();
+  bool publish(const std::string& stat, const std::vector<StatValue>& values);
+
+private:
+  StatsShm::Slot* find_slot(const std::string& stat);
+
+  std::string _name;
+  std::string _directory;
+  StatsShm::Region* _region;
+};
+
+// Reads a component's shared memory file at SNMP request time, applying the
+// stats that have changed since they were last read to their handlers.
+class StatsShmReader
+{
+public:
+  StatsShmReader(const std::string& name,
+                 const std::string& directory = StatsShm::DEFAULT_DIRECTORY) :
+    _name(name),
+    _directory(directory),
+    _region(NULL),
+    _inode(0),
+    _last_check_time(0)
+  {}
+  ~StatsShmReader();
+
+  void refresh(std::map<std::string, ZMQMessageHandler*>& stat_to_handler);
+
+private:
+  // How often we check whether the publisher has replaced the file.
+  enum {REMAP_CHECK_INTERVAL = 1};
+
+  // How many times we try to read a slot while it's being written before
+  // giving up until the next request.
+  enum {MAX_READ_ATTEMPTS = 100};
+
+  void check_mapping(long now);
+  void unmap();
+  bool read_slot(const StatsShm::Slot& slot,
+                 uint32_t& seq,
+                 long& publish_time,
+                 std::vector<StatValue>& values);
+
+  std::string _name;
+  std::string _directory;
+  StatsShm::Region* _region;
+  ino_t _inode;
+  long _last_check_time;
+
+  // The slot index of each stat, and the sequence number of the last values
+  // from that slot that we applied.
+  std::map<std::string, int> _slot_indices;
+  std::map<std::string, uint32_t> _applied_seqs;
+  std::mutex _lock;
+};
+
+#endif
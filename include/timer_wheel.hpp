@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <stdint.h>
+
+class TimerWheel;
+
+/// WheelTimer. Base class for anything that can be scheduled on a
+/// TimerWheel. The timer links itself into the wheel, so scheduling and
+/// cancelling it never allocates.
+class WheelTimer
+{
+public:
+  WheelTimer() :
+    _wheel(nullptr),
+    _prev(nullptr),
+    _next(nullptr),
+    _list(nullptr)
+  {}
+  virtual ~WheelTimer() {}
+
+  // The time (in ms, as returned by Utils::get_time) that the timer is due.
+  virtual uint64_t get_pop_time() const = 0;
+
+protected:
+  // The wheel the timer is on, or nullptr if it isn't scheduled.
+  TimerWheel* _wheel;
+
+private:
+  friend class TimerWheel;
+  friend struct TimerList;
+
+  WheelTimer* _prev;
+  WheelTimer* _next;
+  struct TimerList* _list;
+};
+
+/// TimerList. Intrusive list of the timers in one slot of the wheel.
+struct TimerList
+{
+  TimerList() : head(nullptr), tail(nullptr) {}
+
+  void push_back(WheelTimer* timer);
+  void remove(WheelTimer* timer);
+
+  // Moves all the timers from this list onto the end of another.
+  void splice_onto(TimerList& other);
+
+  bool empty() const { return (head == nullptr); }
+
+  WheelTimer* head;
+  WheelTimer* tail;
+};
+
+/// TimerWheel. A hierarchical timing wheel with millisecond resolution.
+///
+/// The inner wheel has a slot per millisecond for the next ~1 second, and the
+/// outer wheel has a slot per ~1 second for the next ~17 minutes. Timers
+/// further out than that wait on an overflow list. As time passes, the next
+/// outer slot is cascaded into the inner wheel. Inserting, rescheduling and
+/// removing a timer are all O(1).
+///
+/// The wheel isn't thread safe - the caller must serialize access to it.
+class TimerWheel
+{
+public:
+  TimerWheel();
+
+  // Schedules a timer at its current pop time. If the timer is already on
+  // the wheel this is the same as reschedule.
+  void insert(WheelTimer* timer);
+
+  // Moves a timer that's on the wheel to match its current pop time.
+  void reschedule(WheelTimer* timer);
+
+  // Removes a timer from the wheel. Returns false if it wasn't on the wheel.
+  bool remove(WheelTimer* timer);
+
+  // Returns a timer that's due to pop at or before the given time, or
+  // nullptr if there aren't any. The timer stays on the wheel until it's
+  // removed, so calling this again without removing it returns it again.
+  WheelTimer* get_next_due_timer(uint64_t now);
+
+  // Returns a time at or before which the next timer is due to pop (the
+  // caller should then call get_next_due_timer). Returns UINT64_MAX if
+  // the wheel is empty.
+  uint64_t get_next_check_time();
+
+  // Removes all the timers from the wheel.
+  void clear();
+
+private:
+  enum {INNER_BITS = 10,
+        OUTER_BITS = 10,
+        INNER_SLOTS = 1 << INNER_BITS,
+        OUTER_SLOTS = 1 << OUTER_BITS};
+
+  // Places a timer in the right list for its pop time, relative to _now.
+  void add(WheelTimer* timer);
+
+  // Moves _now on to the given time, cascading outer slots and moving any
+  // timers that become due onto the ready list.
+  void advance(uint64_t now);
+
+  // Re-adds all the timers in a list (after _now has moved on).
+  void readd_all(TimerList& list);
+
+  // The time up to which the wheel has been processed. Timers due at or
+  // before this time are on the ready list.
+  uint64_t _now;
+
+  // The number of timers on the wheel (including the ready list), and the
+  // number in the inner wheel.
+  unsigned int _count;
+  unsigned int _inner_count;
+
+  TimerList _inner[INNER_SLOTS];
+  TimerList _outer[OUTER_SLOTS];
+  TimerList _overflow;
+  TimerList _ready;
+};
+
+#endif
@@ -11,21 +11,43 @@
 #define ZMQ_LISTENER_HPP
 
 #include <zmq.h>
+#include <map>
+#include <string>
+#include <vector>
 #include "zmq_message_handler.hpp"
 #include "nodedata.hpp"
 
 class ZMQListener
 {
 public:
-  ZMQListener(NodeData* node_data) : _node_data(node_data) {}
+  // The listener's socket is created in the given ZMQ context, which is
+  // shared between all the listeners in the process.
+  ZMQListener(NodeData* node_data, void* ctx) :
+    _node_data(node_data),
+    _ctx(ctx),
+    _sck(NULL)
+  {}
   ~ZMQListener();
   bool connect_and_subscribe();
-  void handle_requests_forever();
+  bool handle_msg();
+  void update_subscriptions();
+
+  void* socket() { return _sck; }
+  const std::string& name() { return _node_data->name; }
+  NodeData* node_data() { return _node_data; }
 
 private:
+  bool next_msg(std::vector<std::string>& msgs);
+  static bool parse_status(const std::string& status,
+                           bool& has_seq,
+                           StatValue& seq);
+
   NodeData* _node_data;
   void* _ctx;
   void* _sck;
+
+  // Time at which we last dropped the subscription to each stat.
+  std::map<std::string, long> _unsubscribe_times;
 };
 
 #endif
@@ -13,51 +13,349 @@
 #include "oid.hpp"
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <ctime>
 #include "oidtree.hpp"
+#include "stat_rate.hpp"
+#include "rolling_aggregate.hpp"
 
 class ZMQMessageHandler
 {
 public:
-  ZMQMessageHandler(OID oid, OIDTree* tree) : _root_oid(oid), _tree(tree) {};
+  // Number of seconds after the last publish for a stat before we stop
+  // reporting its values.
+  const static int DEFAULT_EXPIRY = 15;
+
+  ZMQMessageHandler(OID oid, OIDTree* tree, int expiry = DEFAULT_EXPIRY) :
+    _root_oid(oid),
+    _subtrees(1, oid),
+    _tree(tree),
+    _expiry(expiry),
+    _last_seen_time(0),
+    _last_access_time(time(NULL)),
+    _unsubscribed(false),
+    _awaiting_publish(false),
+    _pending(false),
+    _has_seq(false),
+    _last_seq(0),
+    _gap_count(0),
+    _resync_needed(false) {};
   virtual void handle(std::vector<std::string>) = 0;
+
+  // Throws away any state built up from earlier publishes, so that the next
+  // publish is applied from scratch.  This is called after publishes have
+  // been missed, so handlers whose state depends on seeing every publish
+  // must override it.
+  virtual void resync() {}
+
+  // Applies a publish, resyncing first if publishes have been missed.
+  void apply(std::vector<std::string>& msgs)
+  {
+    if (_resync_needed.exchange(false))
+    {
+      resync();
+    }
+    handle(msgs);
+  }
+
+  // Checks the sequence number of a publish against the last one seen for
+  // this stat, counting any publishes we've missed (e.g. because the ZMQ
+  // high-water mark was hit or we reconnected).  Only called by the listener.
+  void check_sequence(StatValue seq);
+
+  // Applies stat values that have been published in binary (through shared
+  // memory) rather than as ZMQ frames.  The values are the fields following
+  // "OK" in the equivalent ZMQ publish.  Only handlers whose fields are all
+  // numbers support this.
+  virtual void handle_values(const std::vector<StatValue>& values);
+
+  // Stores the frames of a publish without parsing them, for when values
+  // are only materialized in the tree when an SNMP request needs them.
+  // Only the latest publish is kept.
+  void store_pending(std::vector<std::string>& msgs)
+  {
+    std::lock_guard<std::mutex> guard(_pending_lock);
+    _pending_msgs.swap(msgs);
+    _pending.store(true);
+  }
+
+  // Applies the latest stored publish (if there's one we haven't already
+  // applied) to the tree.
+  void materialize()
+  {
+    if (!_pending.load())
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> materialize_guard(_materialize_lock);
+    std::vector<std::string> msgs;
+    {
+      std::lock_guard<std::mutex> guard(_pending_lock);
+      if (!_pending.load())
+      {
+        return;
+      }
+      msgs.swap(_pending_msgs);
+      _pending.store(false);
+    }
+
+    apply(msgs);
+  }
+
+  // Whether there's a stored publish that hasn't been applied yet.
+  bool has_pending() { return _pending.load(); }
+
+  // Whether the given OID lies in a subtree populated by this handler.
+  bool owns(OID oid);
+
+  // Whether any OID after the given one, up to and including the limit (or
+  // anywhere after it, if there's no limit), lies in a subtree populated by
+  // this handler.
+  bool owns_after(OID oid, const OID* limit);
+
+  // The SNMP type of the value at the given OID.  Stats are Unsigned32
+  // unless the MIB defines them otherwise.
+  virtual u_char asn_type(OID oid) { return ASN_UNSIGNED; }
+
+  // Whether the handler builds up state (such as rates) from the sequence of
+  // publishes, rather than each publish replacing the last.  Such handlers
+  // must see every publish as it arrives, so can't be parsed lazily.
+  virtual bool keeps_history() { return false; }
+
+  // Records that a publish for this stat has just been received.
+  void update_last_seen_time() { update_last_seen_time(time(NULL)); }
+
+  // Records that a publish for this stat was made at the given time.
+  void update_last_seen_time(long publish_time)
+  {
+    _last_seen_time.store(publish_time);
+    _awaiting_publish.store(false);
+  }
+
+  // Whether this stat has been published recently enough for its values to
+  // be reported. While we're deliberately not subscribed to the stat its
+  // last values are still reported (as stale data) rather than expired.
+  bool is_fresh(long now)
+  {
+    return ((_unsubscribed.load()) ||
+            ((now - _last_seen_time.load()) < _expiry));
+  }
+
+  // Whether the values for this stat pre-date our current subscription to it.
+  bool is_stale_marked() { return _awaiting_publish.load(); }
+
+  // Records that an SNMP request has touched this stat.
+  void record_access(long now) { _last_access_time.store(now); }
+  long last_access_time() { return _last_access_time.load(); }
+
+  // Called by the listener when it drops or restores its subscription to
+  // this stat.
+  void set_unsubscribed()
+  {
+    _awaiting_publish.store(true);
+    _unsubscribed.store(true);
+
+    // We're bound to miss publishes while we're unsubscribed, so don't
+    // count them as gaps.
+    _has_seq = false;
+  }
+
+  void set_resubscribed(long now)
+  {
+    // Give the publisher the usual expiry period to send us fresh data
+    // before the stale values stop being reported.
+    _last_seen_time.store(now);
+    _unsubscribed.store(false);
+  }
+
+  bool is_unsubscribed() { return _unsubscribed.load(); }
+
 protected:
+  // Decodes a stat value from a publish field, logging if it's malformed.
+  bool parse_field(const std::string& field, StatValue& value);
+
+  // Decodes the first num_fields values following "OK" in a publish.
+  bool parse_fields(const std::vector<std::string>& msgs,
+                    size_t num_fields,
+                    std::vector<StatValue>& values);
+
   OID _root_oid;
+
+  // The subtrees populated by this handler - by default, the one under its
+  // root OID.  Handlers that share a root OID with other handlers must
+  // replace this with the subtrees they actually populate.
+  std::vector<OID> _subtrees;
+
   OIDTree* _tree;
+  int _expiry;
+  std::atomic_long _last_seen_time;
+  std::atomic_long _last_access_time;
+  std::atomic_bool _unsubscribed;
+  std::atomic_bool _awaiting_publish;
+
+  // The latest unparsed publish, if any.
+  std::atomic_bool _pending;
+  std::vector<std::string> _pending_msgs;
+  std::mutex _pending_lock;
+  std::mutex _materialize_lock;
+
+  // The sequence number of the last publish, if the publisher sends them.
+  bool _has_seq;
+  StatValue _last_seq;
+  std::atomic<uint64_t> _gap_count;
+  std::atomic_bool _resync_needed;
 };
 
 class IPCountStatHandler: public ZMQMessageHandler
 {
 public:
-  IPCountStatHandler(OID oid, OIDTree* tree) : ZMQMessageHandler(oid, tree) {};
+  // The root OIDs for the ConnectionCount tables (bonoConnectedSproutsTable,
+  // sproutConnectedHomersTable, sproutConnectedHomesteadsTable and
+  // mementoConnectedHomesteadsTable) don't contain the element for the
+  // table Entry (always "1") or the element for the ConnectionCount
+  // (always "3"), so the rows go under root.1.3.
+  IPCountStatHandler(OID oid, OIDTree* tree, int expiry = DEFAULT_EXPIRY) :
+    ZMQMessageHandler(oid, tree, expiry),
+    _row_oid(oid, "1.3"),
+    _row_prefix_len(_row_oid.get_len())
+  {};
   void handle(std::vector<std::string>);
+
+private:
+  // Scratch buffer for the row OIDs, which always starts with root.1.3.
+  OID _row_oid;
+  int _row_prefix_len;
 };
 
 class BareStatHandler: public ZMQMessageHandler
 {
 public:
-  BareStatHandler(OID oid, OIDTree* tree) : ZMQMessageHandler(oid, tree) {};
+  // If a rate_oid is given, the average rate of the stat over each of the
+  // rate windows is also exposed, at rate_oid.<window length in seconds>.
+  BareStatHandler(OID oid,
+                  OIDTree* tree,
+                  int expiry = DEFAULT_EXPIRY,
+                  OID rate_oid = OID(),
+                  std::vector<int> rate_windows = StatRate::default_windows()) :
+    ZMQMessageHandler(oid, tree, expiry),
+    _rate_oid(rate_oid),
+    _rate(NULL)
+  {
+    if (_rate_oid.get_len() > 0)
+    {
+      _rate = new StatRate(rate_windows);
+      _subtrees.push_back(_rate_oid);
+    }
+  };
+
+  ~BareStatHandler()
+  {
+    delete _rate;
+    _rate = NULL;
+  }
+
+  bool keeps_history() { return (_rate != NULL); }
+
+  // The rates are built from every publish, so start them again once
+  // publishes have been missed.
+  void resync()
+  {
+    if (_rate != NULL)
+    {
+      _rate->reset();
+    }
+  }
+
   void handle(std::vector<std::string>);
+  void handle_values(const std::vector<StatValue>& values);
+
+private:
+  OID _rate_oid;
+  StatRate* _rate;
+
+  // Scratch buffer for the rate OIDs.
+  OID _rate_cell_oid;
 };
 
 class SingleNumberStatHandler: public ZMQMessageHandler
 {
 public:
-  SingleNumberStatHandler(OID oid, OIDTree* tree) : ZMQMessageHandler(oid, tree) {};
+  SingleNumberStatHandler(OID oid, OIDTree* tree, int expiry = DEFAULT_EXPIRY) :
+    ZMQMessageHandler(oid, tree, expiry),
+    _scalar_oid(oid, 0) // Indicates a scalar value in SNMP
+  {};
   void handle(std::vector<std::string>);
+  void handle_values(const std::vector<StatValue>& values);
+
+private:
+  OID _scalar_oid;
 };
 
 class SingleNumberWithScopeStatHandler: public ZMQMessageHandler
 {
 public:
-  SingleNumberWithScopeStatHandler(OID oid, OIDTree* tree) : ZMQMessageHandler(oid, tree) {};
+  SingleNumberWithScopeStatHandler(OID oid, OIDTree* tree, int expiry = DEFAULT_EXPIRY) :
+    ZMQMessageHandler(oid, tree, expiry),
+    _count_oid(oid, "1.2")
+  {};
   void handle(std::vector<std::string>);
+  void handle_values(const std::vector<StatValue>& values);
+
+private:
+  OID _count_oid;
 };
 
 class AccumulatedWithCountStatHandler: public ZMQMessageHandler
 {
 public:
-  AccumulatedWithCountStatHandler(OID oid, OIDTree* tree) : ZMQMessageHandler(oid, tree) {};
+  // Columns 2-6 hold the latest publish.  They're followed by the rolling
+  // aggregates for each window in turn, in the same order.
+  enum {FIRST_ROLLING_COLUMN = 7, NUM_ROLLING_FIELDS = 5};
+
+  AccumulatedWithCountStatHandler(OID oid, OIDTree* tree, int expiry = DEFAULT_EXPIRY) :
+    ZMQMessageHandler(oid, tree, expiry),
+    _average_oid(oid, "1.2"),
+    _variance_oid(oid, "1.3"),
+    _hwm_oid(oid, "1.4"),
+    _lwm_oid(oid, "1.5"),
+    _count_oid(oid, "1.6")
+  {
+    for (int ii = 0;
+         ii < RollingAggregate::NUM_WINDOWS * NUM_ROLLING_FIELDS;
+         ii++)
+    {
+      OID column_oid(oid, 1);
+      column_oid.append(FIRST_ROLLING_COLUMN + ii);
+      _rolling_oids.push_back(column_oid);
+    }
+  };
   void handle(std::vector<std::string>);
+  void handle_values(const std::vector<StatValue>& values);
+  bool keeps_history() { return true; }
+
+  // The rolling aggregates are built from every publish, so start them
+  // again once publishes have been missed.
+  void resync() { _rolling.reset(); }
+
+private:
+  OID _average_oid;
+  OID _variance_oid;
+  OID _hwm_oid;
+  OID _lwm_oid;
+  OID _count_oid;
+
+  RollingAggregate _rolling;
+  std::vector<OID> _rolling_oids;
 };
 
+// Sets a stat value in a variable, in the type the stat's handler says the
+// MIB defines for it (Unsigned32 if there's no handler).  Values that have
+// grown past an Unsigned32 are reported at the maximum rather than wrapping.
+void set_stat_value(netsnmp_variable_list* var,
+                    ZMQMessageHandler* stat_handler,
+                    OID& stat_oid,
+                    StatValue value);
+
 #endif
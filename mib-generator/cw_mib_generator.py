@@ -17,20 +17,29 @@ Script should be run directly using Python 2.7 or >3.3.
 NOTE: If the supplied output directory already contains a file with the same
 name as the output MIB, it will be over-written!
 
+If --stats-headers is supplied, the C++ headers declaring the OIDs, handlers
+and node data for the stats plugins are generated instead, from the Project
+Clearwater MIB fragments and the given JSON mapping of ZMQ stats to MIB
+objects.
+
 Usage:
   cw_mib_generator.py [--cwc-mib-dir=DIR] OUTPUT_DIR
+  cw_mib_generator.py --stats-headers=FILE OUTPUT_DIR
 
 Arguments:
-    OUTPUT_DIR       Directory for writing output MIBs
+    OUTPUT_DIR       Directory for writing output MIBs (or headers)
 
 Options:
-  --cwc-mib-dir=DIR  Directory containing Clearwater Core MIB fragment
+  --cwc-mib-dir=DIR     Directory containing Clearwater Core MIB fragment
+  --stats-headers=FILE  JSON file mapping stats to MIB objects
 """
 
 from __future__ import print_function
 import sys
 import subprocess
 import os.path
+import json
+import re
 from string import Template
 from docopt import docopt
 
@@ -54,6 +63,42 @@ CWC_MIB_NAME = "METASWITCH-CLEARWATER-CORE-MIB"
 # files - so add this extra statement to the auto-generated MIBs.
 EDIT_STATEMENT = "-- THIS MIB IS BUILT FROM A TEMPLATE - DO NOT EDIT DIRECTLY!"
 
+# Matches the definition of any named node in a MIB fragment, capturing its
+# name, its parent's name and its index under the parent.
+MIB_NODE_REGEX = re.compile(
+    r'^[ \t]*([a-z]\w*)\s+'
+    r'(?:OBJECT IDENTIFIER|OBJECT-TYPE|MODULE-IDENTITY|OBJECT-GROUP|'
+    r'MODULE-COMPLIANCE|NOTIFICATION-TYPE|NOTIFICATION-GROUP)\b'
+    r'.*?::=\s*\{\s*([a-zA-Z]\w*)\s+(\d+)\s*\}',
+    re.MULTILINE | re.DOTALL)
+
+# Column indices, within the table entry, that each table handler fills in.
+# These are checked against the MIB when generating the stats headers.
+HANDLER_COLUMNS = {
+    # The latest publish, then the rolling 5, 15 and 60 minute aggregates.
+    "AccumulatedWithCountStatHandler": list(range(2, 22)),
+}
+
+# Handlers that build up state (rates or rolling aggregates) from every
+# publish, so can't be parsed lazily or read from shared memory.
+HISTORY_HANDLERS = ["AccumulatedWithCountStatHandler"]
+
+# Banner for the generated stats headers, which must only be modified via the
+# MIB fragments and the stats JSON file.
+STATS_HEADER_BANNER = """\
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// THIS FILE IS GENERATED BY mib-generator/cw_mib_generator.py FROM THE MIB
+// FRAGMENTS AND {json_name} - DO NOT EDIT DIRECTLY!
+"""
+
 
 def main(args):
     """
@@ -64,7 +109,13 @@ def main(args):
     common_dir = os.path.dirname(os.path.realpath(__file__))
     output_dir = os.path.abspath(args['OUTPUT_DIR'])
 
-    if args['--cwc-mib-dir']:
+    if args['--stats-headers']:
+        stats_path = os.path.abspath(args['--stats-headers'])
+
+        print("Generating stats headers at {}".format(output_dir))
+        generate_stats_headers(common_dir, stats_path, output_dir)
+        print("Successfully generated stats headers!")
+    elif args['--cwc-mib-dir']:
         cwc_dir = os.path.abspath(args['--cwc-mib-dir'])
 
         print("Generating Clearwater Core MIB at {}".format(output_dir))
@@ -211,6 +262,243 @@ def verify_mib(common_dir, mib_path):
         print(stderr)
         sys.exit("ERROR: MIB failed validation!")
 
+
+def parse_mib_nodes(mib_data):
+    """
+    Find the parent and index of every named node defined in the given MIB
+    data.
+
+    Args:
+        mib_data (str): MIB source
+
+    Returns:
+        dict: Maps node name to a (parent name, index) tuple
+    """
+    return {match.group(1): (match.group(2), int(match.group(3)))
+            for match in MIB_NODE_REGEX.finditer(mib_data)}
+
+
+def resolve_oid(nodes, name):
+    """
+    Resolve a MIB node name into its full numeric OID.
+
+    Args:
+        nodes (dict): Output of parse_mib_nodes
+        name (str): Name of the node to resolve
+
+    Returns:
+        list: The OID, as a list of ints
+    """
+    oid = []
+    while name != "iso":
+        if name not in nodes:
+            sys.exit("ERROR: MIB object {} is not defined!".format(name))
+        name, index = nodes[name]
+        oid.insert(0, index)
+
+    return [1] + oid
+
+
+def find_child(nodes, parent, index):
+    """
+    Find the name of the node at the given index under the given parent, or
+    None if there isn't one.
+    """
+    for name, (node_parent, node_index) in nodes.items():
+        if node_parent == parent and node_index == index:
+            return name
+
+    return None
+
+
+def camel_to_snake(name):
+    """
+    Convert a MIB object name (e.g. cdivAsTotal) into a C++ identifier in the
+    style of the plugins (e.g. cdiv_as_total).
+    """
+    name = re.sub(r'([A-Z]+)([A-Z][a-z])', r'\1_\2', name)
+    return re.sub(r'([a-z0-9])([A-Z])', r'\1_\2', name).lower()
+
+
+def oid_array_name(mib_object):
+    return "{}_oid".format(camel_to_snake(mib_object))
+
+
+def handler_columns(nodes, stat):
+    """
+    Check that the MIB table for a stat has the columns its handler fills in,
+    and return their names.
+
+    Returns:
+        list: (index, column name) tuples; empty if the handler isn't a table
+            handler
+    """
+    columns = []
+    indices = HANDLER_COLUMNS.get(stat['handler'], [])
+
+    if indices:
+        entry = find_child(nodes, stat['object'], 1)
+        for index in indices:
+            column = entry and find_child(nodes, entry, index)
+            if column is None:
+                sys.exit("ERROR: {} has no column {} for {}!".format(
+                    stat['object'], index, stat['handler']))
+            columns.append((index, column))
+
+    return columns
+
+
+def keeps_history(stat):
+    """
+    Whether the handler for a stat builds up state from every publish.
+    """
+    return 'rate_object' in stat or stat['handler'] in HISTORY_HANDLERS
+
+
+def check_node_data(node_data):
+    """
+    Check that the node data's options are supported by all its stats.
+    """
+    for option, description in [('lazy_parse', "be parsed lazily"),
+                                ('shm_transport', "use shared memory")]:
+        if node_data.get(option):
+            for stat in node_data['stats']:
+                if keeps_history(stat):
+                    sys.exit("ERROR: {} can't {}, as {} keeps history!".format(
+                        node_data['node_data'], description, stat['stat']))
+
+
+def render_stats_header(header_name, json_name, node_datas, nodes):
+    """
+    Render the C++ header for one stats plugin.
+
+    Args:
+        header_name (str): File name of the header
+        json_name (str): File name of the stats JSON, for the banner
+        node_datas (list): The plugin's node data definitions from the JSON
+        nodes (dict): Output of parse_mib_nodes
+
+    Returns:
+        str: Contents of the header
+    """
+    guard = re.sub(r'\W', '_', header_name).upper()
+    lines = [STATS_HEADER_BANNER.format(json_name=json_name),
+             "#ifndef {}".format(guard),
+             "#define {}".format(guard),
+             "",
+             '#include "globals.hpp"',
+             '#include "nodedata.hpp"',
+             '#include "zmq_message_handler.hpp"',
+             ""]
+
+    # OID arrays, one per MIB object (shared where stats use the same object).
+    arrays = []
+    for node_data in node_datas:
+        mib_objects = [node_data['root']]
+        for stat in node_data['stats']:
+            mib_objects.append(stat['object'])
+            if 'rate_object' in stat:
+                mib_objects.append(stat['rate_object'])
+
+        for mib_object in mib_objects:
+            if mib_object not in arrays:
+                arrays.append(mib_object)
+
+    for mib_object in arrays:
+        lines.append("// {}".format(mib_object))
+        lines.append("static const oid {}[] = {{{}}};".format(
+            oid_array_name(mib_object),
+            ", ".join(str(i) for i in resolve_oid(nodes, mib_object))))
+    lines.append("")
+
+    for node_data in node_datas:
+        check_node_data(node_data)
+        for stat in node_data['stats']:
+            for index, column in handler_columns(nodes, stat):
+                lines.append("// {} column {}: {}".format(stat['stat'],
+                                                          index,
+                                                          column))
+            array = oid_array_name(stat['object'])
+            if 'rate_object' in stat:
+                # Counter stats can also expose their rates, for which the
+                # handler needs the rate column.
+                rate_array = oid_array_name(stat['rate_object'])
+                lines.append("static {} {}_handler(OID({}, OID_LENGTH({})),"
+                             .format(stat['handler'], stat['stat'], array, array))
+                indent = " " * len("static {} {}_handler(".format(stat['handler'],
+                                                                  stat['stat']))
+                lines.append("{}&tree,".format(indent))
+                lines.append("{}ZMQMessageHandler::DEFAULT_EXPIRY,".format(indent))
+                lines.append("{}OID({}, OID_LENGTH({})));".format(indent,
+                                                                  rate_array,
+                                                                  rate_array))
+            else:
+                lines.append("static {} {}_handler(OID({}, OID_LENGTH({})), &tree);"
+                             .format(stat['handler'], stat['stat'], array, array))
+        lines.append("")
+
+        root_array = oid_array_name(node_data['root'])
+        indent = " " * len("static NodeData {}(".format(node_data['node_data']))
+        stat_names = ",\n{} ".format(indent).join(
+            '"{}"'.format(stat['stat']) for stat in node_data['stats'])
+        stat_handlers = ",\n{} ".format(indent).join(
+            '{{"{0}", &{0}_handler}}'.format(stat['stat'])
+            for stat in node_data['stats'])
+
+        lines.append('static NodeData {}("{}",'.format(node_data['node_data'],
+                                                       node_data['name']))
+        lines.append("{}OID({}, OID_LENGTH({})),".format(indent,
+                                                         root_array,
+                                                         root_array))
+        lines.append("{}{{{}}},".format(indent, stat_names))
+        lines.append("{}{{{}}},".format(indent, stat_handlers))
+        lines.append("{}NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,".format(indent))
+        lazy_parse = "true" if node_data.get('lazy_parse') else "false"
+        if node_data.get('shm_transport'):
+            # Components that publish through shared memory are read at
+            # request time instead of being subscribed to.
+            lines.append("{}{},".format(indent, lazy_parse))
+            lines.append("{}true);".format(indent))
+        else:
+            lines.append("{}{});".format(indent, lazy_parse))
+        lines.append("")
+
+    lines.append("#endif")
+    return "\n".join(lines) + "\n"
+
+
+def generate_stats_headers(common_dir, stats_path, output_dir):
+    """
+    Generates a C++ header per stats plugin, declaring its OIDs, stat handlers
+    and node data, from the Project Clearwater MIB fragments. Existing headers
+    in output_dir are over-written.
+
+    Args:
+        common_dir (str): Directory containing the MIB fragments.
+        stats_path (str): Path to the JSON file mapping each header to its
+            node data, and each ZMQ stat to its MIB object and handler.
+        output_dir (str): Output directory for the headers.
+    """
+    mib_data = (read_mib_fragment(os.path.join(common_dir, COMMON_MIB)) +
+                read_mib_fragment(os.path.join(common_dir, PC_EXTRAS)))
+    nodes = parse_mib_nodes(mib_data)
+
+    try:
+        with open(stats_path, "r") as stats_file:
+            headers = json.load(stats_file)
+    except (IOError, ValueError):
+        print("ERROR: Could not read stats JSON file!")
+        raise
+
+    json_name = "mib-generator/{}".format(os.path.basename(stats_path))
+    for header_name in sorted(headers):
+        header = render_stats_header(header_name,
+                                     json_name,
+                                     headers[header_name],
+                                     nodes)
+        write_mib_file(os.path.join(output_dir, header_name), header)
+
+
 if __name__ == "__main__":
     args = docopt(__doc__)
     main(args)
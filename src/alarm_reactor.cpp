@@ -0,0 +1,260 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+
+#include "log.h"
+#include "utils.h"
+#include "alarm_reactor.hpp"
+
+AlarmReactor::~AlarmReactor()
+{
+  int fds[] = {_epoll_fd, _timer_fd, _event_fd};
+
+  for (int fd : fds)
+  {
+    if (fd != -1)
+    {
+      ::close(fd);
+    }
+  }
+}
+
+bool AlarmReactor::init()
+{
+  _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (_epoll_fd == -1)
+  {
+    TRC_ERROR("epoll_create1 failed: %s", strerror(errno));
+    return false;
+  }
+
+  _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (_timer_fd == -1)
+  {
+    TRC_ERROR("timerfd_create failed: %s", strerror(errno));
+    return false;
+  }
+
+  _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_event_fd == -1)
+  {
+    TRC_ERROR("eventfd failed: %s", strerror(errno));
+    return false;
+  }
+
+  _zmq_fd = _alarm_req_listener->get_fd();
+  if (_zmq_fd == -1)
+  {
+    return false;
+  }
+
+  return (add_fd(_timer_fd) && add_fd(_event_fd) && add_fd(_zmq_fd));
+}
+
+bool AlarmReactor::add_fd(int fd)
+{
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+
+  if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+  {
+    TRC_ERROR("epoll_ctl failed for fd %d: %s", fd, strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+void AlarmReactor::stop()
+{
+  uint64_t one = 1;
+  ssize_t rc = write(_event_fd, &one, sizeof(one));
+  (void)rc;
+}
+
+void AlarmReactor::run()
+{
+  while (1)
+  {
+    // The ZMQ file descriptor is edge triggered, so handle every request
+    // that's waiting before we wait on it again.
+    _alarm_req_listener->handle_ready_requests();
+
+    // Find out what Net-SNMP is waiting for.
+    int num_fds = 0;
+    fd_set snmp_fds;
+    FD_ZERO(&snmp_fds);
+    struct timeval snmp_timeout_tv;
+    timerclear(&snmp_timeout_tv);
+    int block = 1;
+
+    pthread_mutex_lock(&_snmp_lock);
+    snmp_select_info(&num_fds, &snmp_fds, &snmp_timeout_tv, &block);
+    pthread_mutex_unlock(&_snmp_lock);
+
+    update_snmp_fds(num_fds, &snmp_fds);
+
+    int timeout_ms = -1;
+    uint64_t snmp_deadline = UINT64_MAX;
+    if (!block)
+    {
+      timeout_ms = (snmp_timeout_tv.tv_sec * 1000) +
+                   ((snmp_timeout_tv.tv_usec + 999) / 1000);
+      snmp_deadline = Utils::get_time() + timeout_ms;
+    }
+
+    arm_timer(_alarm_scheduler->get_next_check_time());
+
+    struct epoll_event events[MAX_EVENTS];
+    int num_events = epoll_wait(_epoll_fd, events, MAX_EVENTS, timeout_ms);
+
+    if (num_events == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      // LCOV_EXCL_START
+      TRC_ERROR("epoll_wait failed: %s", strerror(errno));
+      return;
+      // LCOV_EXCL_STOP
+    }
+
+    fd_set readable_fds;
+    FD_ZERO(&readable_fds);
+    bool snmp_readable = false;
+
+    for (int ii = 0; ii < num_events; ii++)
+    {
+      int fd = events[ii].data.fd;
+
+      if (fd == _event_fd)
+      {
+        TRC_STATUS("Alarm agent event loop stopping");
+        return;
+      }
+      else if (fd == _timer_fd)
+      {
+        uint64_t expirations;
+        ssize_t rc = read(_timer_fd, &expirations, sizeof(expirations));
+        (void)rc;
+        _timer_armed_for = 0;
+
+        _alarm_scheduler->send_due_alarms();
+      }
+      else if (fd == _zmq_fd)
+      {
+        // Handled at the top of the loop.
+      }
+      else
+      {
+        FD_SET(fd, &readable_fds);
+        snmp_readable = true;
+      }
+    }
+
+    pthread_mutex_lock(&_snmp_lock);
+
+    if (snmp_readable)
+    {
+      snmp_read(&readable_fds);
+    }
+
+    if (Utils::get_time() >= snmp_deadline)
+    {
+      snmp_timeout();
+    }
+
+    run_alarms();
+    netsnmp_check_outstanding_agent_requests();
+
+    pthread_mutex_unlock(&_snmp_lock);
+  }
+}
+
+void AlarmReactor::update_snmp_fds(int num_fds, fd_set* fds)
+{
+  std::set<int> wanted;
+
+  for (int fd = 0; fd < num_fds; fd++)
+  {
+    if (FD_ISSET(fd, fds))
+    {
+      wanted.insert(fd);
+    }
+  }
+
+  for (std::set<int>::iterator it = _snmp_fds.begin();
+       it != _snmp_fds.end();
+       ++it)
+  {
+    if (wanted.count(*it) == 0)
+    {
+      // The socket may already have been closed, which removes it from the
+      // epoll set anyway, so ignore errors.
+      epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, *it, NULL);
+    }
+  }
+
+  for (std::set<int>::iterator it = wanted.begin(); it != wanted.end(); )
+  {
+    if ((_snmp_fds.count(*it) == 0) && (!add_fd(*it)))
+    {
+      it = wanted.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  _snmp_fds.swap(wanted);
+}
+
+void AlarmReactor::arm_timer(uint64_t check_time)
+{
+  // UINT64_MAX means there's nothing to wait for, so disarm the timer (which
+  // an all zero time does). Any real time is at least 1.
+  uint64_t armed_for = (check_time == UINT64_MAX) ?
+                                     0 : std::max(check_time, (uint64_t)1);
+
+  if (armed_for == _timer_armed_for)
+  {
+    return;
+  }
+
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_sec = armed_for / 1000;
+  its.it_value.tv_nsec = (armed_for % 1000) * 1000000;
+
+  if (timerfd_settime(_timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+  {
+    // LCOV_EXCL_START
+    TRC_ERROR("timerfd_settime failed: %s", strerror(errno));
+    return;
+    // LCOV_EXCL_STOP
+  }
+
+  _timer_armed_for = armed_for;
+}
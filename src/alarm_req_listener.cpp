@@ -59,6 +59,18 @@ bool AlarmReqListener::start(sem_t* term_sem)
     // LCOV_EXCL_STOP
   }
 
+  rc = pthread_create(&_worker, NULL, &worker_thread, (void*)this);
+  if (rc != 0)
+  {
+    // LCOV_EXCL_START - No mock for pthread_create
+    TRC_ERROR("error creating worker thread: %s", strerror(rc));
+    zmq_clean_ctx();
+    pthread_join(_thread, NULL);
+    return false;
+    // LCOV_EXCL_STOP
+  }
+  _worker_running = true;
+
   return true;
 }
 
@@ -67,6 +79,18 @@ void AlarmReqListener::stop()
   zmq_clean_ctx();
 
   pthread_join(_thread, NULL);
+
+  // Let the worker finish off any requests we've already acknowledged.
+  if (_worker_running)
+  {
+    pthread_mutex_lock(&_queue_lock);
+    _stopping = true;
+    pthread_cond_signal(&_queue_cond);
+    pthread_mutex_unlock(&_queue_lock);
+
+    pthread_join(_worker, NULL);
+    _worker_running = false;
+  }
 }
 
 void* AlarmReqListener::listener_thread(void* alarm_req_listener)
@@ -83,6 +107,12 @@ void* AlarmReqListener::listener_thread(void* alarm_req_listener)
   return NULL;
 }
 
+void* AlarmReqListener::worker_thread(void* alarm_req_listener)
+{
+  ((AlarmReqListener*)alarm_req_listener)->worker();
+  return NULL;
+}
+
 bool AlarmReqListener::zmq_init_ctx()
 {
   _ctx = zmq_ctx_new();
@@ -97,7 +127,7 @@ bool AlarmReqListener::zmq_init_ctx()
 
 bool AlarmReqListener::zmq_init_sck()
 {
-  _sck = zmq_socket(_ctx, ZMQ_REP);
+  _sck = zmq_socket(_ctx, ZMQ_ROUTER);
 
   if (_sck == NULL)
   {
@@ -183,6 +213,71 @@ void AlarmReqListener::zmq_clean_sck()
   }
 }
 
+bool AlarmReqListener::open()
+{
+  _term_sem = NULL;
+  _inline_requests = true;
+
+  if (!zmq_init_ctx())
+  {
+    return false;
+  }
+
+  if (!zmq_init_sck())
+  {
+    zmq_clean_ctx();
+    return false;
+  }
+
+  return true;
+}
+
+void AlarmReqListener::close()
+{
+  zmq_clean_sck();
+  zmq_clean_ctx();
+}
+
+int AlarmReqListener::get_fd()
+{
+  int fd = -1;
+  size_t fd_sz = sizeof(fd);
+
+  if (zmq_getsockopt(_sck, ZMQ_FD, &fd, &fd_sz) == -1)
+  {
+    TRC_ERROR("zmq_getsockopt failed: %s", zmq_strerror(errno));
+    return -1;
+  }
+
+  return fd;
+}
+
+void AlarmReqListener::handle_ready_requests()
+{
+  while (1)
+  {
+    // The socket's file descriptor only tells us that the socket's state may
+    // have changed, so check whether there's actually a request to read.
+    int events = 0;
+    size_t events_sz = sizeof(events);
+
+    if ((zmq_getsockopt(_sck, ZMQ_EVENTS, &events, &events_sz) == -1) ||
+        ((events & ZMQ_POLLIN) == 0))
+    {
+      return;
+    }
+
+    std::vector<std::string> msg;
+
+    if (!next_msg(msg, ZMQ_DONTWAIT))
+    {
+      return;
+    }
+
+    handle_msg(msg);
+  }
+}
+
 void AlarmReqListener::listener()
 {
   pthread_mutex_lock(&_start_mutex);
@@ -197,34 +292,151 @@ void AlarmReqListener::listener()
       zmq_clean_sck();
       return;
     }
-    // The ZMQ message read here contains the name of the alarm
-    // issuer e.g. "monit" and the alarm identifier e.g. "1000.3"
-    // Note the alarm identifier uses ituAlarmPerceivedSeverity. We can
-    // translate this to alarmModelState using the function 
-    // AlarmTableDef::state - this mapping is described in RFC 3877
-    // section 5.4: https://tools.ietf.org/html/rfc3877#section-5.4
-    if ((msg[0].compare("issue-alarm") == 0) && (msg.size() == 3))
-    {
-      _alarm_scheduler->issue_alarm(msg[1], msg[2]);
-    }
-    else if ((msg[0].compare("sync-alarms") == 0) && (msg.size() == 1))
+
+    handle_msg(msg);
+  }
+}
+
+void AlarmReqListener::handle_msg(std::vector<std::string>& msg)
+{
+  // The ROUTER socket puts the client's identity and an empty delimiter
+  // frame in front of the request.  We need to send them back with the
+  // reply for it to reach the client.
+  if (msg.size() < 2)
+  {
+    TRC_ERROR("alarm request has no envelope: %lu", msg.size());
+    return;
+  }
+  std::vector<std::string> envelope(msg.begin(), msg.begin() + 2);
+  std::vector<std::string> req(msg.begin() + 2, msg.end());
+  bool queued = true;
+
+  // The ZMQ message read here contains the name of the alarm
+  // issuer e.g. "monit" and the alarm identifier e.g. "1000.3"
+  // Note the alarm identifier uses ituAlarmPerceivedSeverity. We can
+  // translate this to alarmModelState using the function 
+  // AlarmTableDef::state - this mapping is described in RFC 3877
+  // section 5.4: https://tools.ietf.org/html/rfc3877#section-5.4
+  if ((req.size() == 3) && (req[0].compare("issue-alarm") == 0))
+  {
+    Request request;
+    request.type = Request::ISSUE_ALARM;
+    request.alarms.push_back(std::make_pair(req[1], req[2]));
+    queued = queue_request(request);
+  }
+  else if ((req.size() >= 3) &&
+           (req.size() % 2 == 1) &&
+           (req[0].compare("issue-alarms") == 0))
+  {
+    // A batch of alarms, as issuer and identifier pairs.
+    Request request;
+    request.type = Request::ISSUE_ALARMS;
+    for (size_t ii = 1; ii < req.size(); ii += 2)
     {
-      _alarm_scheduler->sync_alarms();
+      request.alarms.push_back(std::make_pair(req[ii], req[ii + 1]));
     }
-    else if ((msg[0].compare("poll") == 0) && (msg.size() == 1))
+    queued = queue_request(request);
+  }
+  else if ((req.size() == 1) && (req[0].compare("sync-alarms") == 0))
+  {
+    Request request;
+    request.type = Request::SYNC_ALARMS;
+    queued = queue_request(request);
+  }
+  else if ((req.size() == 1) && (req[0].compare("poll") == 0))
+  {
+    // do nothing, just reply "ok"
+  }
+  else
+  {
+    TRC_ERROR("unexpected alarm request: %s, %lu",
+              req.empty() ? "" : req[0].c_str(),
+              req.size());
+  }
+
+  if (queued)
+  {
+    reply(envelope, "ok");
+  }
+  else
+  {
+    TRC_WARNING("Alarm request queue is full, rejecting %s request",
+                req[0].c_str());
+    reply(envelope, "busy");
+  }
+}
+
+bool AlarmReqListener::queue_request(const Request& request)
+{
+  if (_inline_requests)
+  {
+    // There's no worker thread, so pass the request straight on.
+    process_request(request);
+    return true;
+  }
+
+  pthread_mutex_lock(&_queue_lock);
+  bool queued = (_queue.size() < MAX_QUEUED_REQUESTS);
+  if (queued)
+  {
+    _queue.push_back(request);
+    pthread_cond_signal(&_queue_cond);
+  }
+  pthread_mutex_unlock(&_queue_lock);
+
+  return queued;
+}
+
+// Passes queued requests to the alarm scheduler, in the order they arrived.
+void AlarmReqListener::worker()
+{
+  pthread_mutex_lock(&_queue_lock);
+
+  while (1)
+  {
+    while ((_queue.empty()) && (!_stopping))
     {
-      // do nothing, just reply "ok"
+      pthread_cond_wait(&_queue_cond, &_queue_lock);
     }
-    else
+
+    if (_queue.empty())
     {
-      TRC_ERROR("unexpected alarm request: %s, %lu", msg[0].c_str(), msg.size());
+      break;
     }
 
-    reply("ok");
+    Request request = _queue.front();
+    _queue.pop_front();
+
+    // Don't hold the queue lock while the scheduler waits for its own
+    // lock, or the listener would block queueing the next request.
+    pthread_mutex_unlock(&_queue_lock);
+
+    process_request(request);
+
+    pthread_mutex_lock(&_queue_lock);
+  }
+
+  pthread_mutex_unlock(&_queue_lock);
+}
+
+void AlarmReqListener::process_request(const Request& request)
+{
+  if (request.type == Request::ISSUE_ALARM)
+  {
+    _alarm_scheduler->issue_alarm(request.alarms[0].first,
+                                  request.alarms[0].second);
+  }
+  else if (request.type == Request::ISSUE_ALARMS)
+  {
+    _alarm_scheduler->issue_alarms(request.alarms);
+  }
+  else
+  {
+    _alarm_scheduler->sync_alarms();
   }
 }
 
-bool AlarmReqListener::next_msg(std::vector<std::string>& msg)
+bool AlarmReqListener::next_msg(std::vector<std::string>& msg, int flags)
 {
   int rc;
 
@@ -241,14 +453,18 @@ bool AlarmReqListener::next_msg(std::vector<std::string>& msg)
       return false;
     }
 
-    while (((rc = zmq_msg_recv(&msg_part, _sck, 0)) == -1) && (errno == EINTR))
+    // The flags only apply to the first part - the rest of the message is
+    // always available once the first part is.
+    while (((rc = zmq_msg_recv(&msg_part, _sck, msg.empty() ? flags : 0)) == -1) &&
+           (errno == EINTR))
     {
       // Ignore possible errors due to a syscall being interrupted by a signal.
     }
 
     if (rc == -1)
     {
-      if (errno != ETERM)
+      if ((errno != ETERM) &&
+          (((flags & ZMQ_DONTWAIT) == 0) || (errno != EAGAIN)))
       {
         TRC_ERROR("zmq_msg_recv failed: %s", zmq_strerror(errno));
       }
@@ -284,8 +500,20 @@ bool AlarmReqListener::next_msg(std::vector<std::string>& msg)
   return true;
 }
 
-void AlarmReqListener::reply(const char* response)
+void AlarmReqListener::reply(const std::vector<std::string>& envelope,
+                             const char* response)
 {
+  for (std::vector<std::string>::const_iterator it = envelope.begin();
+       it != envelope.end();
+       ++it)
+  {
+    if (zmq_send(_sck, it->data(), it->size(), ZMQ_SNDMORE) == -1)
+    {
+      TRC_ERROR("zmq_send failed: %s", zmq_strerror(errno));
+      return;
+    }
+  }
+
   if (zmq_send(_sck, response, strlen(response), 0) == -1)
   {
     TRC_ERROR("zmq_send failed: %s", zmq_strerror(errno));
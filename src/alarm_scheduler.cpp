@@ -8,82 +8,117 @@
 */
 
 #include <time.h>
+#include <set>
+#include <algorithm>
 
 #include "log.h"
 #include "alarm_scheduler.hpp"
 #include "itu_alarm_table.hpp"
 #include "alarm_active_table.hpp"
 
-SingleAlarmManager::~SingleAlarmManager()
-{
-  delete _alarm_timer; _alarm_timer = NULL;
-}
-
 void SingleAlarmManager::update_alarm_state(AlarmTableDef& alarm_table_def)
 {
-  // Update the severity in the map.
+  // Update the severity in the table. The Active Alarm Table is updated
+  // separately, under the agent lock.
   _severity = alarm_table_def.severity();
-
-  // Update the ActiveAlarmTable.
-  alarmActiveTable_trap_handler(alarm_table_def);
 }
 
 void SingleAlarmManager::change_schedule(AlarmDef::Severity new_severity,
                                 uint64_t time_to_delay_in_ms)
 {
-  // Update the alarm in the heap's severity, and update its time to pop
-  // (which also rebalances the heap).
-  if (new_severity != _alarm_timer->severity())
+  // Update the severity of the alarm on the wheel, and update its time to pop
+  // (which also moves it on the wheel). If the alarm was only going to be
+  // resent to some sinks, it's now sent to all of them.
+  if ((new_severity != _alarm_timer.severity()) ||
+      (!_alarm_timer.retry_sinks().empty()))
   {
-    _alarm_timer->set_severity(new_severity);
-    _alarm_timer->update_pop_time(time_to_delay_in_ms);
+    _alarm_timer.set_severity(new_severity);
+    _alarm_timer.retry_sinks().clear();
+    _alarm_timer.update_pop_time(time_to_delay_in_ms);
   }
 }
 
 AlarmScheduler::AlarmScheduler(AlarmTableDefs* alarm_table_defs, 
                                std::set<NotificationType> snmp_notifications,
                                std::string hostname,
-                               pthread_mutex_t& lock) :
+                               pthread_mutex_t& snmp_lock,
+                               bool run_threads) :
   _terminated(false),
   _alarm_table_defs(alarm_table_defs),
-  _lock(lock)
+  _snmp_lock(snmp_lock),
+  _resync_interval_us(0),
+  _resync_burst_us(0),
+  _resync_tat_us(0),
+  _run_threads(run_threads),
+  _dispatch_terminated(false)
 {
-  AlarmTrapSender::get_instance().initialise(this, snmp_notifications, hostname);
+  AlarmTrapSender::get_instance().initialise(this,
+                                             alarm_table_defs,
+                                             snmp_notifications,
+                                             hostname);
 
-  // Create the condition variables.
+  // Create the scheduler lock and condition variables.
+  pthread_mutex_init(&_lock, NULL);
 #ifdef UNIT_TEST
   _cond = new MockPThreadCondVar(&_lock);
 #else
   _cond = new CondVar(&_lock);
 #endif
 
-  // Populate the alarm state map
+  // Populate the alarm state table. We only have one entry for each alarm
+  // index (not one per severity).
+  std::set<AlarmIndex> alarm_indexes;
   for (AlarmTableDefsIterator it = _alarm_table_defs->begin();
                               it != _alarm_table_defs->end();
                               it++)
   {
-    std::map<AlarmIndex, SingleAlarmManager*>::iterator index =
-                                      _all_alarms_state.find(it->alarm_index());
-    if (index == _all_alarms_state.end())
-    {
-      // We only have one entry for each alarm index (not one per severity).
-      AlarmTimer* alarm_timer = new AlarmTimer(it->alarm_index());
-      SingleAlarmManager* single_alarm_manager =
-                 new SingleAlarmManager(alarm_timer,
-                                        AlarmDef::Severity::UNDEFINED_SEVERITY);
-      _all_alarms_state.insert(std::make_pair(it->alarm_index(),
-                                              single_alarm_manager));
-    }
+    alarm_indexes.insert(it->alarm_index());
+  }
+
+  _first_alarm_index = alarm_indexes.empty() ? 0 : *alarm_indexes.begin();
+  if (!alarm_indexes.empty())
+  {
+    _alarm_slots.resize(*alarm_indexes.rbegin() - _first_alarm_index + 1, -1);
+  }
+
+  _all_alarms_state.reserve(alarm_indexes.size());
+  for (std::set<AlarmIndex>::iterator it = alarm_indexes.begin();
+       it != alarm_indexes.end();
+       ++it)
+  {
+    _alarm_slots[*it - _first_alarm_index] = _all_alarms_state.size();
+    _all_alarms_state.emplace_back(*it, AlarmDef::Severity::UNDEFINED_SEVERITY);
+  }
+
+  pthread_mutex_init(&_dispatch_lock, NULL);
+  pthread_cond_init(&_dispatch_cond, NULL);
+
+  if (!_run_threads)
+  {
+    // The caller sends due alarms from its own event loop.
+    return;
+  }
+
+  // Create the dispatch thread. This takes alarms that are due to be sent
+  // and passes them to the trap sender to actually send.
+  int rc = pthread_create(&_dispatch_thread, NULL, dispatcher_function, this);
+
+  if (rc < 0)
+  {
+    // LCOV_EXCL_START
+    printf("Failed to start trap dispatch thread: %s", strerror(errno));
+    exit(2);
+    // LCOV_EXCL_STOP
   }
 
-  // Finally, create the heap thread. This covers getting any alarms to send
-  // from the heap and passing them to the trap sender to actually send.
-  int rc = pthread_create(&_heap_sender_thread, NULL, heap_sender_function, this);
+  // Finally, create the wheel thread. This covers getting any alarms to send
+  // from the wheel and passing them to the dispatch thread.
+  rc = pthread_create(&_wheel_sender_thread, NULL, wheel_sender_function, this);
 
   if (rc < 0)
   {
     // LCOV_EXCL_START
-    printf("Failed to start heap pop thread: %s", strerror(errno));
+    printf("Failed to start wheel pop thread: %s", strerror(errno));
     exit(2);
     // LCOV_EXCL_STOP
   }
@@ -91,86 +126,74 @@ AlarmScheduler::AlarmScheduler(AlarmTableDefs* alarm_table_defs,
 
 AlarmScheduler::~AlarmScheduler()
 {
-  pthread_mutex_lock(&_lock);
-  _terminated = true;
-  _cond->signal();
-  pthread_mutex_unlock(&_lock);
+  if (_run_threads)
+  {
+    pthread_mutex_lock(&_lock);
+    _terminated = true;
+    _cond->signal();
+    pthread_mutex_unlock(&_lock);
+
+    pthread_join(_wheel_sender_thread, NULL);
+
+    // Any alarms that are still waiting to be dispatched are dropped, just as
+    // any alarms still on the wheel are.
+    pthread_mutex_lock(&_dispatch_lock);
+    _dispatch_terminated = true;
+    pthread_cond_signal(&_dispatch_cond);
+    pthread_mutex_unlock(&_dispatch_lock);
+
+    pthread_join(_dispatch_thread, NULL);
+  }
 
-  pthread_join(_heap_sender_thread, NULL);
   delete _cond; _cond = NULL;
+  pthread_cond_destroy(&_dispatch_cond);
+  pthread_mutex_destroy(&_dispatch_lock);
 
   pthread_mutex_destroy(&_lock);
 
-  _alarm_heap.clear();
-
-  for (std::pair<AlarmIndex, SingleAlarmManager*> pair : _all_alarms_state)
-  {
-    delete pair.second;
-  }
+  _alarm_wheel.clear();
 }
 
-void* AlarmScheduler::heap_sender_function(void* data)
+void* AlarmScheduler::wheel_sender_function(void* data)
 {
-  ((AlarmScheduler*)data)->heap_sender();
+  ((AlarmScheduler*)data)->wheel_sender();
   return NULL;
 }
 
-void AlarmScheduler::heap_sender()
+void AlarmScheduler::wheel_sender()
 {
   pthread_mutex_lock(&_lock);
 
   while (!_terminated)
   {
-    uint64_t time_now_in_ms = Utils::get_time();
-    AlarmTimer* alarm_timer = (AlarmTimer*)_alarm_heap.get_next_timer();
+    std::deque<AlarmToSend> alarms_to_send;
+    pop_due_alarms(alarms_to_send);
 
-    while ((alarm_timer) &&
-           (alarm_timer->get_pop_time() <= time_now_in_ms))
+    if (!alarms_to_send.empty())
     {
-      // For each alarm in the heap that's due to be sent, we:
-      //  - Pull out the alarm definition for its index and severity.
-      //  - Pass the alarm definition to the trap sender (which is responsible
-      //    for actually sending any INFORMs).
-      //  - Update the master view of the current severity for this alarm (by
-      //    updating the _all_alarms_state map).
-      //  - Finally, we then remove the alarm from the heap.
-      AlarmTableDef& alarm_table_def =
-              _alarm_table_defs->get_definition(alarm_timer->index(),
-                                                alarm_timer->severity());
-
-      if (alarm_table_def.is_valid())
-      {
-        AlarmTrapSender::get_instance().send_trap(alarm_table_def);
-        std::map<AlarmIndex, SingleAlarmManager*>::iterator alarm =
-                                 _all_alarms_state.find(alarm_timer->index());
-
-        if (alarm != _all_alarms_state.end())
-        {
-          alarm->second->update_alarm_state(alarm_table_def);
-        }
-        else
-        {
-          // LCOV_EXCL_START - logic error
-          TRC_ERROR("Logic error - unable to handle alarm");
-          // LCOV_EXCL_STOP
-        }
-      }
-
-      alarm_timer->remove_from_heap();
-      alarm_timer = (AlarmTimer*)_alarm_heap.get_next_timer();
+      // Hand the alarms over to the dispatch thread. This only holds the
+      // dispatch lock briefly, so we don't wait for Net-SNMP here.
+      pthread_mutex_lock(&_dispatch_lock);
+      _dispatch_queue.insert(_dispatch_queue.end(),
+                             alarms_to_send.begin(),
+                             alarms_to_send.end());
+      pthread_cond_signal(&_dispatch_cond);
+      pthread_mutex_unlock(&_dispatch_lock);
     }
 
-    if (alarm_timer)
+    uint64_t next_check_time = _alarm_wheel.get_next_check_time();
+
+    if (next_check_time != UINT64_MAX)
     {
-      // The next alarm in the heap isn't due to pop yet. Wait until it's due.
+      // The next alarm on the wheel isn't due to pop yet. Wait until it's due.
       struct timespec time;
-      time.tv_sec = alarm_timer->get_pop_time() / 1000;
-      time.tv_nsec = (alarm_timer->get_pop_time() % 1000) * 1000000;
+      time.tv_sec = next_check_time / 1000;
+      time.tv_nsec = (next_check_time % 1000) * 1000000;
       _cond->timedwait(&time);
     }
     else
     {
-      // There are no alarms in the heap. Wait until we're signalled.
+      // There are no alarms on the wheel. Wait until we're signalled.
       _cond->wait();
     }
   }
@@ -178,13 +201,130 @@ void AlarmScheduler::heap_sender()
   pthread_mutex_unlock(&_lock);
 }
 
-void AlarmScheduler::remove_outdated_alarm_from_heap(
+void AlarmScheduler::pop_due_alarms(std::deque<AlarmToSend>& alarms_to_send)
+{
+  uint64_t time_now_in_ms = Utils::get_time();
+  AlarmTimer* alarm_timer =
+               (AlarmTimer*)_alarm_wheel.get_next_due_timer(time_now_in_ms);
+
+  while (alarm_timer)
+  {
+    // For each alarm on the wheel that's due to be sent, we:
+    //  - Pull out the alarm definition for its index and severity.
+    //  - Queue the alarm definition to be passed to the trap sender (which
+    //    is responsible for actually sending any INFORMs).
+    //  - Update the master view of the current severity for this alarm (by
+    //    updating the _all_alarms_state table).
+    //  - Finally, we then remove the alarm from the wheel.
+    AlarmTableDef& alarm_table_def =
+            _alarm_table_defs->get_definition(alarm_timer->index(),
+                                              alarm_timer->severity());
+
+    if (alarm_table_def.is_valid())
+    {
+      AlarmToSend alarm_to_send;
+      alarm_to_send.alarm_table_def = &alarm_table_def;
+      alarm_to_send.sinks.swap(alarm_timer->retry_sinks());
+      alarms_to_send.push_back(alarm_to_send);
+      SingleAlarmManager* alarm = alarm_state(alarm_timer->index());
+
+      if (alarm != NULL)
+      {
+        alarm->update_alarm_state(alarm_table_def);
+      }
+      else
+      {
+        // LCOV_EXCL_START - logic error
+        TRC_ERROR("Logic error - unable to handle alarm");
+        // LCOV_EXCL_STOP
+      }
+    }
+
+    alarm_timer->remove_from_wheel();
+    alarm_timer = (AlarmTimer*)_alarm_wheel.get_next_due_timer(time_now_in_ms);
+  }
+}
+
+uint64_t AlarmScheduler::get_next_check_time()
+{
+  pthread_mutex_lock(&_lock);
+  uint64_t next_check_time = _alarm_wheel.get_next_check_time();
+  pthread_mutex_unlock(&_lock);
+
+  return next_check_time;
+}
+
+void AlarmScheduler::send_due_alarms()
+{
+  std::deque<AlarmToSend> alarms_to_send;
+
+  pthread_mutex_lock(&_lock);
+  pop_due_alarms(alarms_to_send);
+  pthread_mutex_unlock(&_lock);
+
+  send_alarms(alarms_to_send);
+}
+
+void* AlarmScheduler::dispatcher_function(void* data)
+{
+  ((AlarmScheduler*)data)->dispatcher();
+  return NULL;
+}
+
+void AlarmScheduler::dispatcher()
+{
+  std::deque<AlarmToSend> alarms_to_send;
+
+  pthread_mutex_lock(&_dispatch_lock);
+
+  while (!_dispatch_terminated)
+  {
+    if (_dispatch_queue.empty())
+    {
+      pthread_cond_wait(&_dispatch_cond, &_dispatch_lock);
+      continue;
+    }
+
+    // Take everything that's queued, and send it without holding the
+    // dispatch lock so that the wheel thread can keep queueing alarms.
+    alarms_to_send.swap(_dispatch_queue);
+    pthread_mutex_unlock(&_dispatch_lock);
+
+    send_alarms(alarms_to_send);
+    alarms_to_send.clear();
+
+    pthread_mutex_lock(&_dispatch_lock);
+  }
+
+  pthread_mutex_unlock(&_dispatch_lock);
+}
+
+void AlarmScheduler::send_alarms(std::deque<AlarmToSend>& alarms_to_send)
+{
+  for (std::deque<AlarmToSend>::iterator it = alarms_to_send.begin();
+       it != alarms_to_send.end();
+       ++it)
+  {
+    pthread_mutex_lock(&_snmp_lock);
+    AlarmTrapSender::get_instance().send_trap(*it->alarm_table_def, it->sinks);
+
+    // A resend to particular sinks doesn't change the alarm's state.
+    if (it->sinks.empty())
+    {
+      alarmActiveTable_trap_handler(*it->alarm_table_def);
+    }
+
+    pthread_mutex_unlock(&_snmp_lock);
+  }
+}
+
+void AlarmScheduler::remove_outdated_alarm_from_wheel(
                                        SingleAlarmManager* single_alarm_manager)
 {
   if (single_alarm_manager->severity() !=
       single_alarm_manager->alarm_timer()->severity())
   {
-    _alarm_heap.remove(single_alarm_manager->alarm_timer());
+    _alarm_wheel.remove(single_alarm_manager->alarm_timer());
     _cond->signal();
   }
 }
@@ -194,7 +334,7 @@ void AlarmScheduler::change_schedule_for_alarm(
                                        AlarmDef::Severity severity,
                                        uint64_t alarm_pop_time_ms)
 {
-  _alarm_heap.insert(single_alarm_manager->alarm_timer());
+  _alarm_wheel.insert(single_alarm_manager->alarm_timer());
   single_alarm_manager->change_schedule(severity, alarm_pop_time_ms);
 }
 
@@ -214,6 +354,49 @@ bool AlarmScheduler::validate_alarm_trigger(std::string identifier,
   return alarm_table_def.is_valid();
 }
 
+bool AlarmScheduler::schedule_alarm(AlarmIndex index,
+                                    AlarmDef::Severity severity)
+{
+  bool signal = false;
+
+  SingleAlarmManager* alarm = alarm_state(index);
+
+  if (alarm != NULL)
+  {
+    if (severity == alarm->severity())
+    {
+      // The severity of the alarm hasn't changed. If there's an alarm on the
+      // wheel with a different severity remove it.
+      TRC_DEBUG("Severity of the alarm %u hasn't changed", index);
+      remove_outdated_alarm_from_wheel(alarm);
+    }
+    else if (severity > alarm->severity())
+    {
+      TRC_DEBUG("Severity of the alarm %u has increased", index);
+      change_schedule_for_alarm(alarm,
+                                severity,
+                                ALARM_INCREASED_DELAY);
+      signal = true;
+    }
+    else
+    {
+      TRC_DEBUG("Severity of the alarm %u has reduced", index);
+      change_schedule_for_alarm(alarm,
+                                severity,
+                                ALARM_REDUCED_DELAY);
+      signal = true;
+    }
+  }
+  else
+  {
+    // LCOV_EXCL_START - logic error
+    TRC_ERROR("Logic error - unable to handle alarm");
+    // LCOV_EXCL_STOP
+  }
+
+  return signal;
+}
+
 void AlarmScheduler::issue_alarm(const std::string& issuer,
                                  const std::string& identifier)
 {
@@ -224,50 +407,131 @@ void AlarmScheduler::issue_alarm(const std::string& issuer,
   {
     pthread_mutex_lock(&_lock);
 
-    std::map<AlarmIndex, SingleAlarmManager*>::iterator alarm =
-                                                  _all_alarms_state.find(index);
-
-    if (alarm != _all_alarms_state.end())
+    if (schedule_alarm(index, (AlarmDef::Severity)severity))
     {
-      AlarmDef::Severity severity_as_enum = (AlarmDef::Severity)severity;
+      _cond->signal();
+    }
 
-      if (severity_as_enum == alarm->second->severity())
-      {
-        // The severity of the alarm hasn't changed. If there's an alarm in the
-        // heap with a different severity remove it.
-        TRC_DEBUG("Severity of the alarm %u hasn't changed", index);
-        remove_outdated_alarm_from_heap(alarm->second);
-      }
-      else if (severity_as_enum > alarm->second->severity())
-      {
-        TRC_DEBUG("Severity of the alarm %u has increased", index);
-        change_schedule_for_alarm(alarm->second,
-                                  severity_as_enum,
-                                  ALARM_INCREASED_DELAY);
-        _cond->signal();
-      }
-      else
-      {
-        TRC_DEBUG("Severity of the alarm %u has reduced", index);
-        change_schedule_for_alarm(alarm->second,
-                                  severity_as_enum,
-                                  ALARM_REDUCED_DELAY);
-        _cond->signal();
-      }
+    pthread_mutex_unlock(&_lock);
+  }
+  else
+  {
+    TRC_ERROR("Unknown alarm definition: %s", identifier.c_str());
+  }
+}
+
+void AlarmScheduler::issue_alarms(const AlarmTriggers& alarms)
+{
+  // Validate the whole batch before taking the lock.
+  std::vector<std::pair<AlarmIndex, AlarmDef::Severity>> valid_alarms;
+  valid_alarms.reserve(alarms.size());
+
+  for (AlarmTriggers::const_iterator it = alarms.begin();
+       it != alarms.end();
+       ++it)
+  {
+    unsigned int index;
+    unsigned int severity;
+
+    if (validate_alarm_trigger(it->second, index, severity))
+    {
+      valid_alarms.push_back(std::make_pair(index,
+                                            (AlarmDef::Severity)severity));
     }
     else
     {
-      // LCOV_EXCL_START - logic error
-      TRC_ERROR("Logic error - unable to handle alarm");
-      // LCOV_EXCL_STOP
+      TRC_ERROR("Unknown alarm definition: %s", it->second.c_str());
     }
+  }
 
-    pthread_mutex_unlock(&_lock);
+  if (valid_alarms.empty())
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&_lock);
+
+  bool signal = false;
+  for (std::vector<std::pair<AlarmIndex, AlarmDef::Severity>>::iterator it =
+                                                         valid_alarms.begin();
+       it != valid_alarms.end();
+       ++it)
+  {
+    signal |= schedule_alarm(it->first, it->second);
+  }
+
+  if (signal)
+  {
+    _cond->signal();
+  }
+
+  pthread_mutex_unlock(&_lock);
+}
+
+// The order in which alarms are resent on a resync - raised alarms before
+// clears, most severe first.
+static int resync_priority(AlarmDef::Severity severity)
+{
+  switch (severity)
+  {
+  case AlarmDef::Severity::CRITICAL:
+    return 0;
+  case AlarmDef::Severity::MAJOR:
+    return 1;
+  case AlarmDef::Severity::MINOR:
+    return 2;
+  case AlarmDef::Severity::WARNING:
+    return 3;
+  case AlarmDef::Severity::INDETERMINATE:
+    return 4;
+  default:
+    return 5;
+  }
+}
+
+void AlarmScheduler::set_resync_rate(unsigned int alarms_per_second,
+                                     unsigned int burst)
+{
+  pthread_mutex_lock(&_lock);
+
+  if (alarms_per_second == 0)
+  {
+    _resync_interval_us = 0;
+    _resync_burst_us = 0;
   }
   else
   {
-    TRC_ERROR("Unknown alarm definition: %s", identifier.c_str());
+    _resync_interval_us = 1000000 / alarms_per_second;
+    _resync_burst_us = _resync_interval_us * ((burst > 0) ? burst - 1 : 0);
   }
+
+  _resync_tat_us = 0;
+
+  pthread_mutex_unlock(&_lock);
+}
+
+uint64_t AlarmScheduler::take_resync_token()
+{
+  if (_resync_interval_us == 0)
+  {
+    return 0;
+  }
+
+  uint64_t now_us = Utils::get_time() * 1000;
+  uint64_t delay_us = 0;
+
+  if (_resync_tat_us < now_us)
+  {
+    _resync_tat_us = now_us;
+  }
+  else if (_resync_tat_us > now_us + _resync_burst_us)
+  {
+    delay_us = _resync_tat_us - _resync_burst_us - now_us;
+  }
+
+  _resync_tat_us += _resync_interval_us;
+
+  return (delay_us + 999) / 1000;
 }
 
 void AlarmScheduler::sync_alarms()
@@ -277,44 +541,80 @@ void AlarmScheduler::sync_alarms()
   pthread_mutex_lock(&_lock);
 
   // For all alarms that we know a state for (so we've tried to send an alarm
-  // state to the NMS at least once), resend the current state.
-  for (std::pair<AlarmIndex, SingleAlarmManager*> pair : _all_alarms_state)
+  // state to the NMS at least once), resend the current state, skipping any
+  // that are already waiting to be sent in that state.
+  std::vector<SingleAlarmManager*> alarms_to_resync;
+
+  for (std::vector<SingleAlarmManager>::iterator alarm = _all_alarms_state.begin();
+       alarm != _all_alarms_state.end();
+       ++alarm)
   {
-    AlarmDef::Severity current_severity = pair.second->severity();
+    AlarmDef::Severity current_severity = alarm->severity();
 
-    if (current_severity != AlarmDef::Severity::UNDEFINED_SEVERITY)
+    if ((current_severity != AlarmDef::Severity::UNDEFINED_SEVERITY) &&
+        ((!alarm->alarm_timer()->in_wheel()) ||
+         (alarm->alarm_timer()->severity() != current_severity) ||
+         (!alarm->alarm_timer()->retry_sinks().empty())))
     {
-      change_schedule_for_alarm(pair.second,
-                                current_severity,
-                                ALARM_RESYNC_DELAY);
+      alarms_to_resync.push_back(&(*alarm));
     }
   }
 
+  std::stable_sort(alarms_to_resync.begin(),
+                   alarms_to_resync.end(),
+                   [](SingleAlarmManager* a, SingleAlarmManager* b)
+                   {
+                     return (resync_priority(a->severity()) <
+                             resync_priority(b->severity()));
+                   });
+
+  for (std::vector<SingleAlarmManager*>::iterator alarm = alarms_to_resync.begin();
+       alarm != alarms_to_resync.end();
+       ++alarm)
+  {
+    change_schedule_for_alarm(*alarm,
+                              (*alarm)->severity(),
+                              ALARM_RESYNC_DELAY + take_resync_token());
+  }
+
   _cond->signal();
   pthread_mutex_unlock(&_lock);
 }
 
-void AlarmScheduler::handle_failed_alarm(AlarmTableDef& alarm_table_def)
+void AlarmScheduler::handle_failed_alarm(AlarmTableDef& alarm_table_def,
+                                         snmp_session* sink)
 {
   TRC_DEBUG("Handling an alarm (%u) the NMS didn't respond to",
             alarm_table_def.alarm_index());
 
-  // No need to take a lock - this is only called from Net-SNMP, which must
-  // already have been holding it.
+  // This is called with the agent lock held. That's fine, as the agent lock
+  // can be held while taking the scheduler lock.
+  pthread_mutex_lock(&_lock);
 
-  std::map<AlarmIndex, SingleAlarmManager*>::iterator alarm =
-                          _all_alarms_state.find(alarm_table_def.alarm_index());
+  SingleAlarmManager* alarm = alarm_state(alarm_table_def.alarm_index());
 
-  if (alarm != _all_alarms_state.end())
+  if (alarm != NULL)
   {
-    // If the alarm status hasn't changed, reschedule the alarm
-    if (alarm->second->should_resend_alarm(alarm_table_def.severity()))
+    AlarmTimer* alarm_timer = alarm->alarm_timer();
+    std::vector<snmp_session*>& retry_sinks = alarm_timer->retry_sinks();
+
+    // If the alarm status hasn't changed, reschedule the alarm, to be resent
+    // to just this sink. If it's already due to be resent to other sinks,
+    // add this one.
+    if (alarm->should_resend_alarm(alarm_table_def.severity()))
     {
-      change_schedule_for_alarm(alarm->second,
+      change_schedule_for_alarm(alarm,
                                 alarm_table_def.severity(),
                                 ALARM_RETRY_DELAY);
+      retry_sinks.push_back(sink);
       _cond->signal();
     }
+    else if ((alarm->is_resending_alarm(alarm_table_def.severity())) &&
+             (std::find(retry_sinks.begin(), retry_sinks.end(), sink) ==
+                                                            retry_sinks.end()))
+    {
+      retry_sinks.push_back(sink);
+    }
   }
   else
   {
@@ -323,5 +623,5 @@ void AlarmScheduler::handle_failed_alarm(AlarmTableDef& alarm_table_def)
     // LCOV_EXCL_STOP
   }
 
-  // No need to release a lock - see comment at the top of the function.
+  pthread_mutex_unlock(&_lock);
 }
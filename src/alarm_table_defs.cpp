@@ -36,6 +36,23 @@ unsigned int AlarmTableDef::state() const
   return severity_to_state[idx];
 }
 
+const std::string AlarmTableDef::EMPTY_STRING;
+
+void AlarmTableDef::intern_strings(AlarmTableStrings& strings)
+{
+  const std::string** fields[] = {&_name, &_description, &_details, &_cause,
+                                  &_effect, &_action, &_extended_details,
+                                  &_extended_description};
+
+  for (const std::string** field : fields)
+  {
+    if (*field != &EMPTY_STRING)
+    {
+      *field = strings.intern(**field);
+    }
+  }
+}
+
 bool AlarmTableDefKey::operator<(const AlarmTableDefKey& rhs) const
 {
   return  (_index  < rhs._index) ||
@@ -72,6 +89,8 @@ bool AlarmTableDefs::initialize(std::string& path)
     rc = false;
   }
 
+  build_lookup();
+
   return rc;
 }
 
@@ -106,8 +125,7 @@ bool AlarmTableDefs::populate_map(std::string path,
 
     for (s_it = a_it->_severity_details.begin(); s_it != a_it->_severity_details.end(); s_it++)
     {
-      AlarmTableDef def(*a_it, *s_it);
-      AlarmTableDefs::insert_def(def);
+      AlarmTableDefs::insert_def(make_definition(*a_it, *s_it));
     }
   }
   return rc;
@@ -119,12 +137,62 @@ void AlarmTableDefs::insert_def(AlarmTableDef def)
   _key_to_def.emplace(key, def);
 }
 
-AlarmTableDef& AlarmTableDefs::get_definition(unsigned int index, 
+void AlarmTableDefs::intern_strings()
+{
+  for (std::map<AlarmTableDefKey, AlarmTableDef>::iterator it = _key_to_def.begin();
+       it != _key_to_def.end();
+       ++it)
+  {
+    it->second.intern_strings(_strings);
+  }
+}
+
+void AlarmTableDefs::build_lookup()
+{
+  _lookup.clear();
+  _first_index = 0;
+
+  if (_key_to_def.empty())
+  {
+    return;
+  }
+
+  // The map is ordered by alarm index, so the first and last entries give
+  // the range of indexes.
+  _first_index = _key_to_def.begin()->second.alarm_index();
+  unsigned int num_indexes =
+              _key_to_def.rbegin()->second.alarm_index() - _first_index + 1;
+  _lookup.resize(num_indexes * NUM_SEVERITIES, NULL);
+
+  for (std::map<AlarmTableDefKey, AlarmTableDef>::iterator it = _key_to_def.begin();
+       it != _key_to_def.end();
+       it++)
+  {
+    unsigned int severity = it->second.severity();
+
+    if (severity < NUM_SEVERITIES)
+    {
+      unsigned int offset = it->second.alarm_index() - _first_index;
+      _lookup[(offset * NUM_SEVERITIES) + severity] = &(it->second);
+    }
+  }
+}
+
+AlarmTableDef& AlarmTableDefs::get_definition(unsigned int index,
                                               unsigned int severity)
 {
-  AlarmTableDefKey key(index, severity);
+  if ((index < _first_index) || (severity >= NUM_SEVERITIES))
+  {
+    return _invalid_def;
+  }
+
+  size_t slot = ((size_t)(index - _first_index) * NUM_SEVERITIES) + severity;
 
-  std::map<AlarmTableDefKey, AlarmTableDef>::iterator it = _key_to_def.find(key);
+  if (slot >= _lookup.size())
+  {
+    return _invalid_def;
+  }
 
-  return (it != _key_to_def.end()) ? it->second : _invalid_def;
+  AlarmTableDef* def = _lookup[slot];
+  return (def != NULL) ? *def : _invalid_def;
 }
@@ -22,10 +22,6 @@
 #include "itu_alarm_table.hpp"
 #include "alarm_active_table.hpp"
 
-#define CREATE_NETSNMP_LIST(LIST_NAME) \
-  netsnmp_variable_list LIST_NAME; \
-  memset(&LIST_NAME, 0x00, sizeof(LIST_NAME)); 
-
 // This is a date in the format YYYYMMDDHHMM that specfies when the current MIB
 // version was implemented. This should be changed whenever new MIBs are
 // introduced.
@@ -40,12 +36,15 @@ static int alarm_trap_send_callback(int op,
                                     void* correlator)
 {
   AlarmTableDef* alarm_table_def = (AlarmTableDef*)correlator; correlator = NULL;
-  AlarmTrapSender::get_instance().alarm_trap_send_callback(op, *alarm_table_def);
+  AlarmTrapSender::get_instance().alarm_trap_send_callback(op,
+                                                           session,
+                                                           *alarm_table_def);
   return 1;
 }
 
 void AlarmTrapSender::alarm_trap_send_callback(
                                            int op,
+                                           snmp_session* sink,
                                            const AlarmTableDef& alarm_table_def)
 {
   switch (op)
@@ -64,7 +63,8 @@ void AlarmTrapSender::alarm_trap_send_callback(
     // LCOV_EXCL_STOP
   case NETSNMP_CALLBACK_OP_TIMED_OUT:
     TRC_DEBUG("Failed to deliver alarm");
-    _alarm_scheduler->handle_failed_alarm((AlarmTableDef&)alarm_table_def);
+    _alarm_scheduler->handle_failed_alarm((AlarmTableDef&)alarm_table_def,
+                                          sink);
     break;
   default:
     // LCOV_EXCL_START - logic error
@@ -75,11 +75,128 @@ void AlarmTrapSender::alarm_trap_send_callback(
 }
 
 
+// OIDs for RFC3877 compliant traps.
+static const oid snmp_trap_oid[] = {1,3,6,1,6,3,1,1,4,1,0};
+static const oid clear_oid[] = {1,3,6,1,2,1,118,0,3};
+static const oid active_oid[] = {1,3,6,1,2,1,118,0,2};
+static const oid model_ptr_oid[] = {1,3,6,1,2,1,118,1,2,2,1,13,0};
+static const oid model_row_oid[] = {1,3,6,1,2,1,118,1,1,2,1,3,0,1,2};
+static const oid resource_id_oid[] = {1,3,6,1,2,1,118,1,2,2,1,10,0};
+static const oid zero_dot_zero[] = {0,0};
+static const oid sys_up_time_oid[] = {1,3,6,1,2,1,1,3,0};
+
+// OIDs according to the CLEARWATER-ENTERPRISE-MIB.
+static const oid trap_type_oid[] = {1,3,6,1,4,1,19444,12,2,0,1};
+static const oid MIB_version_oid[] = {1,2,826,0,1,1578918,12,1,1};
+static const oid alarm_name_oid[] = {1,3,6,1,4,1,19444,12,2,0,2};
+static const oid alarm_oid_oid[] = {1,3,6,1,4,1,19444,12,2,0,3};
+static const oid ent_resource_id_oid[] = {1,3,6,1,4,1,19444,12,2,0,4};
+static const oid alarm_severity_oid[] = {1,3,6,1,4,1,19444,12,2,0,5};
+static const oid alarm_description_oid[] = {1,3,6,1,4,1,19444,12,2,0,6};
+static const oid alarm_details_oid[] = {1,3,6,1,4,1,19444,12,2,0,7};
+static const oid alarm_cause_oid[] = {1,3,6,1,4,1,19444,12,2,0,8};
+static const oid alarm_effect_oid[] = {1,3,6,1,4,1,19444,12,2,0,9};
+static const oid alarm_action_oid[] = {1,3,6,1,4,1,19444,12,2,0,10};
+static const oid alarm_hostname_oid[] = {1,3,6,1,4,1,19444,12,2,0,12};
+
+// Appends a variable binding to a list. Does nothing if an earlier one
+// failed, and sets ok to false if this one fails.
+static netsnmp_variable_list* add_var(netsnmp_variable_list** vars,
+                                      bool& ok,
+                                      const oid* name,
+                                      size_t name_length,
+                                      u_char type,
+                                      const void* value,
+                                      size_t len)
+{
+  netsnmp_variable_list* var = NULL;
+
+  if (ok)
+  {
+    var = snmp_varlist_add_variable(vars,
+                                    name,
+                                    name_length,
+                                    type,
+                                    (const u_char*)value,
+                                    len);
+    ok = (var != NULL);
+  }
+
+  return var;
+}
+
+AlarmTrapSender::~AlarmTrapSender()
+{
+  free_templates();
+}
+
+void AlarmTrapSender::initialise(AlarmScheduler* alarm_scheduler,
+                                 AlarmTableDefs* alarm_table_defs,
+                                 std::set<NotificationType> snmp_notifications,
+                                 std::string hostname)
+{
+  _alarm_scheduler = alarm_scheduler;
+  _snmp_notifications = snmp_notifications;
+  _hostname = hostname;
+
+  // The variable bindings only depend on the alarm definition, the
+  // notification type and the hostname, so build them all now.
+  free_templates();
+
+  for (AlarmTableDefsIterator it = alarm_table_defs->begin();
+       it != alarm_table_defs->end();
+       it++)
+  {
+    if (!it->is_valid())
+    {
+      continue;
+    }
+
+    TrapTemplates templates = {NULL, NULL};
+
+    if (_snmp_notifications.count(NotificationType::RFC3877) != 0)
+    {
+      templates.rfc3877 = build_rfc3877_vars(*it);
+    }
+
+    if (_snmp_notifications.count(NotificationType::ENTERPRISE) != 0)
+    {
+      templates.enterprise = build_enterprise_vars(*it);
+    }
+
+    _templates[&(*it)] = templates;
+  }
+}
+
+void AlarmTrapSender::free_templates()
+{
+  for (std::unordered_map<const AlarmTableDef*, TrapTemplates>::iterator it =
+                                                            _templates.begin();
+       it != _templates.end();
+       ++it)
+  {
+    snmp_free_varbind(it->second.rfc3877);
+    snmp_free_varbind(it->second.enterprise);
+  }
+
+  _templates.clear();
+}
+
 // Sends an alarmActiveState or alarmClearState inform notification based
 // upon the specified alarm definition. net-snmp will handle the required
 // retires if needed.
-void AlarmTrapSender::send_trap(const AlarmTableDef& alarm_table_def)
+void AlarmTrapSender::send_trap(const AlarmTableDef& alarm_table_def,
+                                const std::vector<snmp_session*>& sinks)
 {
+  TrapTemplates templates = {NULL, NULL};
+  std::unordered_map<const AlarmTableDef*, TrapTemplates>::iterator found =
+                                            _templates.find(&alarm_table_def);
+
+  if (found != _templates.end())
+  {
+    templates = found->second;
+  }
+
   for (std::set<NotificationType>::iterator it = _snmp_notifications.begin();
        it != _snmp_notifications.end();
        ++it)
@@ -87,10 +204,22 @@ void AlarmTrapSender::send_trap(const AlarmTableDef& alarm_table_def)
     switch (*it)
     {
       case NotificationType::RFC3877:
-        send_rfc3877_trap(alarm_table_def);
+        TRC_INFO("RFC3877 compliant trap with alarm ID %d.%d being sent",
+                 alarm_table_def.alarm_index(),
+                 alarm_table_def.state());
+        send_vars(templates.rfc3877,
+                  &AlarmTrapSender::build_rfc3877_vars,
+                  alarm_table_def,
+                  sinks);
         break;
       case NotificationType::ENTERPRISE:
-        send_enterprise_trap(alarm_table_def);
+        TRC_INFO("Enterprise MIB trap with alarm ID %d.%d being sent",
+                 alarm_table_def.alarm_index(),
+                 alarm_table_def.state());
+        send_vars(templates.enterprise,
+                  &AlarmTrapSender::build_enterprise_vars,
+                  alarm_table_def,
+                  sinks);
         break;
       default:
         // LCOV_EXCL_START
@@ -101,170 +230,188 @@ void AlarmTrapSender::send_trap(const AlarmTableDef& alarm_table_def)
   }
 }
 
-void AlarmTrapSender::send_rfc3877_trap(const AlarmTableDef& alarm_table_def)
+void AlarmTrapSender::send_vars(
+               netsnmp_variable_list* vars,
+               netsnmp_variable_list* (AlarmTrapSender::*build)(const AlarmTableDef&),
+               const AlarmTableDef& alarm_table_def,
+               const std::vector<snmp_session*>& sinks)
 {
-  TRC_INFO("RFC3877 compliant trap with alarm ID %d.%d being sent", alarm_table_def.alarm_index(),
-                                                                    alarm_table_def.state());
+  bool temporary = (vars == NULL);
 
-  static const oid snmp_trap_oid[] = {1,3,6,1,6,3,1,1,4,1,0};
-  static const oid clear_oid[] = {1,3,6,1,2,1,118,0,3};
-  static const oid active_oid[] = {1,3,6,1,2,1,118,0,2};
+  if (temporary)
+  {
+    vars = (this->*build)(alarm_table_def);
+  }
 
-  static const oid model_ptr_oid[] = {1,3,6,1,2,1,118,1,2,2,1,13,0};
-  static const oid model_row_oid[] = {1,3,6,1,2,1,118,1,1,2,1,3,0,1,2};
+  if ((vars != NULL) && (sinks.empty()))
+  {
+    // Net-SNMP copies the variable bindings into the PDU for each sink, so
+    // the template is left untouched.
+    send_v2trap(vars, ::alarm_trap_send_callback, (void*)&alarm_table_def);
+  }
+  else if (vars != NULL)
+  {
+    for (std::vector<snmp_session*>::const_iterator it = sinks.begin();
+         it != sinks.end();
+         ++it)
+    {
+      send_inform(*it, vars, alarm_table_def);
+    }
+  }
 
-  static const oid resource_id_oid[] = {1,3,6,1,2,1,118,1,2,2,1,10,0};
-  static const oid zero_dot_zero[] = {0,0};
+  if (temporary)
+  {
+    snmp_free_varbind(vars);
+  }
+}
 
-  CREATE_NETSNMP_LIST(var_trap);
-  CREATE_NETSNMP_LIST(var_model_row);
-  CREATE_NETSNMP_LIST(var_resource_id);
+void AlarmTrapSender::send_inform(netsnmp_session* sink,
+                                  netsnmp_variable_list* vars,
+                                  const AlarmTableDef& alarm_table_def)
+{
+  // Build the PDU as send_v2trap would for each of its sinks - sysUpTime,
+  // followed by a copy of the variable bindings.
+  netsnmp_pdu* pdu = snmp_pdu_create(SNMP_MSG_INFORM);
+  bool ok = (pdu != NULL);
+
+  if (ok)
+  {
+    u_long uptime = netsnmp_get_agent_uptime();
+    add_var(&pdu->variables, ok, sys_up_time_oid, OID_LENGTH(sys_up_time_oid),
+            ASN_TIMETICKS, &uptime, sizeof(uptime));
+  }
+
+  if (ok)
+  {
+    pdu->variables->next_variable = snmp_clone_varbind(vars);
+    ok = (pdu->variables->next_variable != NULL);
+  }
+
+  // Net-SNMP owns the PDU once it's been sent.
+  if ((ok) &&
+      (snmp_async_send(sink,
+                       pdu,
+                       ::alarm_trap_send_callback,
+                       (void*)&alarm_table_def) != 0))
+  {
+    return;
+  }
 
-  var_trap.next_variable = &var_model_row;
-  var_model_row.next_variable = &var_resource_id;
-  var_resource_id.next_variable = NULL;
+  // We couldn't send the INFORM, so treat it as if the sink didn't respond.
+  TRC_WARNING("Failed to send alarm ID %d.%d to %s",
+              alarm_table_def.alarm_index(),
+              alarm_table_def.state(),
+              sink->peername);
+
+  if (pdu != NULL)
+  {
+    snmp_free_pdu(pdu);
+  }
+
+  _alarm_scheduler->handle_failed_alarm((AlarmTableDef&)alarm_table_def, sink);
+}
+
+netsnmp_variable_list* AlarmTrapSender::build_rfc3877_vars(
+                                          const AlarmTableDef& alarm_table_def)
+{
+  netsnmp_variable_list* vars = NULL;
+  bool ok = true;
 
-  snmp_set_var_objid(&var_trap, snmp_trap_oid, OID_LENGTH(snmp_trap_oid));
   if (alarm_table_def.severity() == AlarmDef::CLEARED)
   {
-    snmp_set_var_typed_value(&var_trap, ASN_OBJECT_ID, (u_char*) clear_oid, sizeof(clear_oid));
+    add_var(&vars, ok, snmp_trap_oid, OID_LENGTH(snmp_trap_oid),
+            ASN_OBJECT_ID, clear_oid, sizeof(clear_oid));
   }
   else
   {
-    snmp_set_var_typed_value(&var_trap, ASN_OBJECT_ID, (u_char*) active_oid, sizeof(active_oid));
+    add_var(&vars, ok, snmp_trap_oid, OID_LENGTH(snmp_trap_oid),
+            ASN_OBJECT_ID, active_oid, sizeof(active_oid));
   }
 
-  snmp_set_var_objid(&var_model_row, model_ptr_oid, OID_LENGTH(model_ptr_oid));
-  snmp_set_var_typed_value(&var_model_row, ASN_OBJECT_ID, (u_char*) model_row_oid, sizeof(model_row_oid));
-
-  var_model_row.val.objid[ALARMMODELTABLEROW_INDEX] = alarm_table_def.alarm_index();
-  var_model_row.val.objid[ALARMMODELTABLEROW_STATE] = alarm_table_def.state();
+  netsnmp_variable_list* var_model_row =
+    add_var(&vars, ok, model_ptr_oid, OID_LENGTH(model_ptr_oid),
+            ASN_OBJECT_ID, model_row_oid, sizeof(model_row_oid));
+  add_var(&vars, ok, resource_id_oid, OID_LENGTH(resource_id_oid),
+          ASN_OBJECT_ID, zero_dot_zero, sizeof(zero_dot_zero));
 
-  snmp_set_var_objid(&var_resource_id, resource_id_oid, OID_LENGTH(resource_id_oid));
-  snmp_set_var_typed_value(&var_resource_id, ASN_OBJECT_ID, (u_char*) zero_dot_zero, sizeof(zero_dot_zero));
+  if (!ok)
+  {
+    // LCOV_EXCL_START - only fails if we're out of memory
+    TRC_ERROR("Failed to build RFC3877 trap for alarm ID %d.%d",
+              alarm_table_def.alarm_index(),
+              alarm_table_def.state());
+    snmp_free_varbind(vars);
+    return NULL;
+    // LCOV_EXCL_STOP
+  }
 
-  send_v2trap(&var_trap, ::alarm_trap_send_callback, (void*)&alarm_table_def);
+  var_model_row->val.objid[ALARMMODELTABLEROW_INDEX] = alarm_table_def.alarm_index();
+  var_model_row->val.objid[ALARMMODELTABLEROW_STATE] = alarm_table_def.state();
 
-  snmp_reset_var_buffers(&var_trap);
+  return vars;
 }
 
-void AlarmTrapSender::send_enterprise_trap(const AlarmTableDef& alarm_table_def)
+netsnmp_variable_list* AlarmTrapSender::build_enterprise_vars(
+                                          const AlarmTableDef& alarm_table_def)
 {
-  TRC_INFO("Enterprise MIB trap with alarm ID %d.%d being sent", alarm_table_def.alarm_index(),
-                                                                 alarm_table_def.state());
-
-  // Here we define OIDs according to the CLEARWATER-ENTERPRISE-MIB
-  static const std::string severity_to_string[] = {"UNDEFINED_SEVERITY", 
+  static const std::string severity_to_string[] = {"UNDEFINED_SEVERITY",
                                                    "CLEARED",
-                                                   "INDETERMINATE", 
-                                                   "CRITICAL", 
-                                                   "MAJOR", 
-                                                   "MINOR", 
+                                                   "INDETERMINATE",
+                                                   "CRITICAL",
+                                                   "MAJOR",
+                                                   "MINOR",
                                                    "WARNING"};
-  static const oid snmp_trap_oid[] = {1,3,6,1,6,3,1,1,4,1,0};
-  static const oid trap_type_oid[] = {1,3,6,1,4,1,19444,12,2,0,1};
-  static const oid MIB_version_oid[] = {1,2,826,0,1,1578918,12,1,1};
-  static const oid alarm_name_oid[] = {1,3,6,1,4,1,19444,12,2,0,2};
-  static const oid alarm_oid_oid[] = {1,3,6,1,4,1,19444,12,2,0,3};
-  static const oid resource_id_oid[] = {1,3,6,1,4,1,19444,12,2,0,4};
-  static const oid zero_dot_zero[] = {0,0};
-  static const oid model_row_oid[] = {1,3,6,1,2,1,118,1,1,2,1,3,0,1,2};
-  static const oid alarm_severity_oid[] = {1,3,6,1,4,1,19444,12,2,0,5};
-  static const oid alarm_description_oid[] = {1,3,6,1,4,1,19444,12,2,0,6};
-  static const oid alarm_details_oid[] = {1,3,6,1,4,1,19444,12,2,0,7};
-  static const oid alarm_cause_oid[] = {1,3,6,1,4,1,19444,12,2,0,8};
-  static const oid alarm_effect_oid[] = {1,3,6,1,4,1,19444,12,2,0,9};
-  static const oid alarm_action_oid[] = {1,3,6,1,4,1,19444,12,2,0,10};
-  static const oid alarm_hostname_oid[] = {1,3,6,1,4,1,19444,12,2,0,12};
-  
-  // We create variable lists, wipe them clean and then link them to each other
-  // so only the first needs to be passed to sent_v2trap
-  CREATE_NETSNMP_LIST(var_trap);
-  CREATE_NETSNMP_LIST(var_MIB_version);
-  CREATE_NETSNMP_LIST(var_alarm_name);
-  CREATE_NETSNMP_LIST(var_alarm_oid);
-  CREATE_NETSNMP_LIST(var_resource_id);
-  CREATE_NETSNMP_LIST(var_alarm_severity);
-  CREATE_NETSNMP_LIST(var_alarm_description);
-  CREATE_NETSNMP_LIST(var_alarm_details);
-  CREATE_NETSNMP_LIST(var_alarm_cause);
-  CREATE_NETSNMP_LIST(var_alarm_effect);
-  CREATE_NETSNMP_LIST(var_alarm_action);
-  CREATE_NETSNMP_LIST(var_alarm_hostname);
-  
-  var_trap.next_variable = &var_MIB_version;
-  var_MIB_version.next_variable = &var_alarm_name;
-  var_alarm_name.next_variable = &var_alarm_oid;
-  var_alarm_oid.next_variable = &var_resource_id;
-  var_resource_id.next_variable = &var_alarm_severity;
-  var_alarm_severity.next_variable = &var_alarm_description;
-  var_alarm_description.next_variable = &var_alarm_details;
-  var_alarm_details.next_variable = &var_alarm_cause;
-  var_alarm_cause.next_variable = &var_alarm_effect;
-  var_alarm_effect.next_variable = &var_alarm_action;
-  var_alarm_action.next_variable = &var_alarm_hostname;
-  var_alarm_hostname.next_variable = NULL;
-
-  // Sets the object id of each of the variable lists to the OIDs defined above,
-  // these can be thought of as the keys for each of the variable bindings.
-  snmp_set_var_objid(&var_trap, snmp_trap_oid, OID_LENGTH(snmp_trap_oid));
-  snmp_set_var_objid(&var_MIB_version, MIB_version_oid, OID_LENGTH(MIB_version_oid));
-  snmp_set_var_objid(&var_alarm_name, alarm_name_oid, OID_LENGTH(alarm_name_oid));
-  snmp_set_var_objid(&var_alarm_oid, alarm_oid_oid, OID_LENGTH(alarm_oid_oid));
-  snmp_set_var_objid(&var_resource_id, resource_id_oid, OID_LENGTH(resource_id_oid));
-  snmp_set_var_objid(&var_alarm_severity, alarm_severity_oid, OID_LENGTH(alarm_severity_oid));
-  snmp_set_var_objid(&var_alarm_description, alarm_description_oid, OID_LENGTH(alarm_description_oid));
-  snmp_set_var_objid(&var_alarm_details, alarm_details_oid, OID_LENGTH(alarm_details_oid));
-  snmp_set_var_objid(&var_alarm_cause, alarm_cause_oid, OID_LENGTH(alarm_cause_oid));
-  snmp_set_var_objid(&var_alarm_effect, alarm_effect_oid, OID_LENGTH(alarm_effect_oid));
-  snmp_set_var_objid(&var_alarm_action, alarm_action_oid, OID_LENGTH(alarm_action_oid));
-  snmp_set_var_objid(&var_alarm_hostname, alarm_hostname_oid, OID_LENGTH(alarm_hostname_oid));
-
-  // Sets the value of each of the variable lists, these can be thought of as
-  // the values which correspond to the above keys in the variable bindings.
-  snmp_set_var_typed_value(&var_trap, ASN_OBJECT_ID, 
-                           (u_char*) trap_type_oid, 
-                           sizeof(trap_type_oid));
-  snmp_set_var_typed_value(&var_MIB_version, ASN_OCTET_STR,
-                           MIB_VERSION.c_str(),
-                           MIB_VERSION.length());
-  snmp_set_var_typed_value(&var_alarm_name, ASN_OCTET_STR,
-                           alarm_table_def.name().c_str(),
-                           alarm_table_def.name().length());
-  snmp_set_var_typed_value(&var_alarm_oid, ASN_OBJECT_ID,
-                           (u_char*) model_row_oid,
-                           sizeof(model_row_oid));
-
-  var_alarm_oid.val.objid[ALARMMODELTABLEROW_INDEX] = alarm_table_def.alarm_index();
-  var_alarm_oid.val.objid[ALARMMODELTABLEROW_STATE] = alarm_table_def.state();
-  
-  snmp_set_var_typed_value(&var_resource_id, ASN_OBJECT_ID, 
-                           (u_char*) zero_dot_zero, 
-                           sizeof(zero_dot_zero));
-  snmp_set_var_typed_value(&var_alarm_severity, ASN_OCTET_STR,
-                           severity_to_string[alarm_table_def.severity()].c_str(),
-                           severity_to_string[alarm_table_def.severity()].length());
-  snmp_set_var_typed_value(&var_alarm_description, ASN_OCTET_STR, 
-                           alarm_table_def.extended_description().c_str(), 
-                           alarm_table_def.extended_description().length());
-  snmp_set_var_typed_value(&var_alarm_details, ASN_OCTET_STR, 
-                           alarm_table_def.extended_details().c_str(), 
-                           alarm_table_def.extended_details().length());
-  snmp_set_var_typed_value(&var_alarm_cause, ASN_OCTET_STR, 
-                           alarm_table_def.cause().c_str(), 
-                           alarm_table_def.cause().length());
-  snmp_set_var_typed_value(&var_alarm_effect, ASN_OCTET_STR, 
-                           alarm_table_def.effect().c_str(), 
-                           alarm_table_def.effect().length());
-  snmp_set_var_typed_value(&var_alarm_action, ASN_OCTET_STR, 
-                           alarm_table_def.action().c_str(), 
-                           alarm_table_def.action().length());
-  snmp_set_var_typed_value(&var_alarm_hostname, ASN_OCTET_STR,
-                           _hostname.c_str(),
-                           _hostname.length());
-
-  // Sends the trap passing the function the first of the linked lists.
-  send_v2trap(&var_trap, ::alarm_trap_send_callback, (void*)&alarm_table_def);
-
-  snmp_reset_var_buffers(&var_trap);
+  const std::string& severity = severity_to_string[alarm_table_def.severity()];
+
+  netsnmp_variable_list* vars = NULL;
+  bool ok = true;
+
+  // Each variable binding is an OID (the key) and a value.
+  add_var(&vars, ok, snmp_trap_oid, OID_LENGTH(snmp_trap_oid),
+          ASN_OBJECT_ID, trap_type_oid, sizeof(trap_type_oid));
+  add_var(&vars, ok, MIB_version_oid, OID_LENGTH(MIB_version_oid),
+          ASN_OCTET_STR, MIB_VERSION.c_str(), MIB_VERSION.length());
+  add_var(&vars, ok, alarm_name_oid, OID_LENGTH(alarm_name_oid),
+          ASN_OCTET_STR, alarm_table_def.name().c_str(),
+          alarm_table_def.name().length());
+  netsnmp_variable_list* var_alarm_oid =
+    add_var(&vars, ok, alarm_oid_oid, OID_LENGTH(alarm_oid_oid),
+            ASN_OBJECT_ID, model_row_oid, sizeof(model_row_oid));
+  add_var(&vars, ok, ent_resource_id_oid, OID_LENGTH(ent_resource_id_oid),
+          ASN_OBJECT_ID, zero_dot_zero, sizeof(zero_dot_zero));
+  add_var(&vars, ok, alarm_severity_oid, OID_LENGTH(alarm_severity_oid),
+          ASN_OCTET_STR, severity.c_str(), severity.length());
+  add_var(&vars, ok, alarm_description_oid, OID_LENGTH(alarm_description_oid),
+          ASN_OCTET_STR, alarm_table_def.extended_description().c_str(),
+          alarm_table_def.extended_description().length());
+  add_var(&vars, ok, alarm_details_oid, OID_LENGTH(alarm_details_oid),
+          ASN_OCTET_STR, alarm_table_def.extended_details().c_str(),
+          alarm_table_def.extended_details().length());
+  add_var(&vars, ok, alarm_cause_oid, OID_LENGTH(alarm_cause_oid),
+          ASN_OCTET_STR, alarm_table_def.cause().c_str(),
+          alarm_table_def.cause().length());
+  add_var(&vars, ok, alarm_effect_oid, OID_LENGTH(alarm_effect_oid),
+          ASN_OCTET_STR, alarm_table_def.effect().c_str(),
+          alarm_table_def.effect().length());
+  add_var(&vars, ok, alarm_action_oid, OID_LENGTH(alarm_action_oid),
+          ASN_OCTET_STR, alarm_table_def.action().c_str(),
+          alarm_table_def.action().length());
+  add_var(&vars, ok, alarm_hostname_oid, OID_LENGTH(alarm_hostname_oid),
+          ASN_OCTET_STR, _hostname.c_str(), _hostname.length());
+
+  if (!ok)
+  {
+    // LCOV_EXCL_START - only fails if we're out of memory
+    TRC_ERROR("Failed to build Enterprise MIB trap for alarm ID %d.%d",
+              alarm_table_def.alarm_index(),
+              alarm_table_def.state());
+    snmp_free_varbind(vars);
+    return NULL;
+    // LCOV_EXCL_STOP
+  }
+
+  var_alarm_oid->val.objid[ALARMMODELTABLEROW_INDEX] = alarm_table_def.alarm_index();
+  var_alarm_oid->val.objid[ALARMMODELTABLEROW_STATE] = alarm_table_def.state();
+
+  return vars;
 }
@@ -30,12 +30,22 @@
 #include "itu_alarm_table.hpp"
 #include "alarm_active_table.hpp"
 #include "alarm_scheduler.hpp"
+#include "alarm_reactor.hpp"
 
 static sem_t term_sem;
+static AlarmReactor* alarm_reactor = NULL;
+
 // Signal handler that triggers termination.
 void agent_terminate_handler(int sig)
 {
-  sem_post(&term_sem);
+  if (alarm_reactor != NULL)
+  {
+    alarm_reactor->stop();
+  }
+  else
+  {
+    sem_post(&term_sem);
+  }
 }
 
 enum OptionTypes
@@ -46,7 +56,9 @@ enum OptionTypes
   OPT_HOSTNAME,
   OPT_SNMP_IPS,
   OPT_LOG_LEVEL,
-  OPT_LOG_DIR
+  OPT_LOG_DIR,
+  OPT_REACTOR,
+  OPT_RESYNC_RATE
 };
 
 const static struct option long_opt[] =
@@ -58,6 +70,8 @@ const static struct option long_opt[] =
   { "hostname",                        required_argument, 0, OPT_HOSTNAME},
   { "log-level",                       required_argument, 0, OPT_LOG_LEVEL},
   { "log-dir",                         required_argument, 0, OPT_LOG_DIR},
+  { "reactor",                         no_argument,       0, OPT_REACTOR},
+  { "resync-rate",                     required_argument, 0, OPT_RESYNC_RATE},
 };
 
 static void usage(void)
@@ -72,6 +86,9 @@ static void usage(void)
          " --log-dir <directory>\n"
          "                            Log to file in specified directory\n"
          " --log-level N              Set log level to N (default: 4)\n"
+         " --reactor                  Run the agent from a single event loop thread\n"
+         " --resync-rate N            Resend at most N alarms per second to each sink\n"
+         "                            when resyncing (default: 100, 0 for no limit)\n"
         );
 }
 
@@ -84,6 +101,8 @@ int main (int argc, char **argv)
   std::string hostname = "";
   std::string logdir = "";
   int loglevel = 4;
+  bool use_reactor = false;
+  int resync_rate = 100;
   int c;
   int optind;
 
@@ -133,6 +152,12 @@ int main (int argc, char **argv)
       case OPT_LOG_DIR:
         logdir = optarg;
         break;
+      case OPT_REACTOR:
+        use_reactor = true;
+        break;
+      case OPT_RESYNC_RATE:
+        resync_rate = atoi(optarg);
+        break;
       default:
         usage();
         abort();
@@ -190,11 +215,52 @@ int main (int argc, char **argv)
   init_ituAlarmTable(*alarm_table_defs);
   init_alarmActiveTable(local_ip);
  
+  if (use_reactor)
+  {
+    // Run everything from a single event loop, which does the work of the
+    // SNMP handler thread too.
+    init_snmp("clearwater-alarms");
+
+    AlarmScheduler* alarm_scheduler = new AlarmScheduler(alarm_table_defs, snmp_notifications, hostname, SNMP::Agent::instance()->get_lock(), false);
+    alarm_scheduler->set_resync_rate(resync_rate, resync_rate);
+    AlarmReqListener* alarm_req_listener = new AlarmReqListener(alarm_scheduler);
+    AlarmReactor* reactor = new AlarmReactor(alarm_scheduler,
+                                             alarm_req_listener,
+                                             SNMP::Agent::instance()->get_lock());
+
+    if ((!alarm_req_listener->open()) || (!reactor->init()))
+    {
+      TRC_ERROR("Hit error starting the event loop - shutting down");
+      return 1;
+    }
+
+    TRC_STATUS("Alarm agent has started");
+
+    alarm_reactor = reactor;
+    signal(SIGTERM, agent_terminate_handler);
+
+    reactor->run();
+
+    alarm_reactor = NULL;
+    delete reactor; reactor = NULL;
+    alarm_req_listener->close();
+    delete alarm_req_listener; alarm_req_listener = NULL;
+    delete alarm_scheduler; alarm_scheduler = NULL;
+
+    // There's no SNMP handler thread to stop, so just shut down Net-SNMP.
+    snmp_shutdown("clearwater-alarms");
+
+    delete alarm_table_defs; alarm_table_defs = NULL;
+    return 0;
+  }
+
   init_snmp_handler_threads("clearwater-alarms");
 
   // Construct the alarm scheduler and request listener.  This must be done
-  // after we've initialized SNMP handler threads, as they share the lock.
+  // after we've initialized SNMP handler threads, as the scheduler takes
+  // their lock to send traps and update the Active Alarm Table.
   AlarmScheduler* alarm_scheduler = new AlarmScheduler(alarm_table_defs, snmp_notifications, hostname, SNMP::Agent::instance()->get_lock());
+  alarm_scheduler->set_resync_rate(resync_rate, resync_rate);
   AlarmReqListener* alarm_req_listener = new AlarmReqListener(alarm_scheduler);
 
   // Exit if the ReqListener wasn't able to fully start
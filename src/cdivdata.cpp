@@ -7,40 +7,11 @@
  * Metaswitch Networks in a separate written agreement.
 */
 
-#include "globals.hpp"
-#include "nodedata.hpp"
 #include "custom_handler.hpp"
-#include "zmq_message_handler.hpp"
 
-OID cdiv_total_oid = OID("1.2.826.0.1.1578918.9.7.1.1.2");
-OID cdiv_unconditional_oid = OID("1.2.826.0.1.1578918.9.7.1.1.3");
-OID cdiv_busy_oid = OID("1.2.826.0.1.1578918.9.7.1.1.4");
-OID cdiv_not_registered_oid = OID("1.2.826.0.1.1578918.9.7.1.1.5");
-OID cdiv_no_answer_oid = OID("1.2.826.0.1.1578918.9.7.1.1.6");
-OID cdiv_not_reachable_oid = OID("1.2.826.0.1.1578918.9.7.1.1.7");
-
-BareStatHandler cdiv_total_handler(cdiv_total_oid, &tree);
-BareStatHandler cdiv_unconditional_handler(cdiv_unconditional_oid, &tree);
-BareStatHandler cdiv_busy_handler(cdiv_busy_oid, &tree);
-BareStatHandler cdiv_not_registered_handler(cdiv_not_registered_oid, &tree);
-BareStatHandler cdiv_no_answer_handler(cdiv_no_answer_oid, &tree);
-BareStatHandler cdiv_not_reachable_handler(cdiv_not_reachable_oid, &tree);
-
-NodeData cdiv_node_data("sprout",
-                        OID("1.2.826.0.1.1578918.9.7"),
-                        {"cdiv_total",
-                         "cdiv_unconditional",
-                         "cdiv_busy", 
-                         "cdiv_not_registered",
-                         "cdiv_no_answer", 
-                         "cdiv_not_reachable"},
-                        {{"cdiv_total", &cdiv_total_handler},
-                         {"cdiv_unconditional", &cdiv_unconditional_handler},
-                         {"cdiv_busy", &cdiv_busy_handler},
-                         {"cdiv_not_registered", &cdiv_not_registered_handler},
-                         {"cdiv_no_answer", &cdiv_no_answer_handler},
-                         {"cdiv_not_reachable", &cdiv_not_reachable_handler}
-                        });
+// The OIDs, handlers and node data for these stats are generated from the MIB
+// by mib-generator/cw_mib_generator.py.
+#include "cdiv_stats.hpp"
 
 extern "C"
 {
@@ -8,36 +8,21 @@
 */
 
 #include <ctime>
-#include <pthread.h>
-#include <atomic>
 
 #include "custom_handler.hpp"
 #include "oid.hpp"
 #include "oidtree.hpp"
 #include "nodedata.hpp"
-#include "zmq_listener.hpp"
+#include "stats_host.hpp"
 
+// This is built into the shared stats library, so there's one tree for all
+// the plugins loaded into snmpd.
 OIDTree tree;
-std::atomic_long last_seen_time;
-std::atomic_bool thread_created;
-pthread_mutex_t thread_creation_lock = PTHREAD_MUTEX_INITIALIZER;
-NodeData* global_node_data;
-const int TIMEOUT_THRESHOLD = 15;
-
-void* start_stats (void* node_data_ptr)
-{
-  NodeData* node_data = (NodeData*)node_data_ptr;
-  ZMQListener listener(node_data);
-  listener.handle_requests_forever();
-  return NULL; // Never hit
-}
 
 /** Initialize the Clearwater stats handler and register it */
 void initialize_handler(NodeData* node_data)
 {
   netsnmp_handler_registration* my_handler;
-  thread_created.store(false);
-  last_seen_time.store(0);
   static oid* root;
   snmp_clone_mem((void**)&root,
                  (void*)(node_data->root_oid.get_ptr()),
@@ -56,9 +41,38 @@ void initialize_handler(NodeData* node_data)
     return; /** Serious error. */
   }
 
+  // Each registration serves the stats of its own node data, so stash it on
+  // the registration for clearwater_handler to pick up.
+  my_handler->my_reg_void = node_data;
+
   DEBUGMSGTL(("initialize_handler", "Registering handler for Clearwater stats\n"));
   netsnmp_register_handler(my_handler);
-  global_node_data = node_data;
+
+  // Stats in shared memory are only read on request, so publishes between
+  // requests are missed.  Handlers that keep history need every publish, so
+  // plugins with any of those have to subscribe over ZMQ instead.
+  for (std::map<std::string, ZMQMessageHandler*>::iterator it = node_data->stat_to_handler.begin();
+       (node_data->shm_transport) && (it != node_data->stat_to_handler.end());
+       ++it)
+  {
+    if (it->second->keeps_history())
+    {
+      snmp_log(LOG_ERR,
+               "Stat %s keeps history so can't be read from shared memory - subscribing to %s stats over ZMQ",
+               it->first.c_str(),
+               node_data->name.c_str());
+      node_data->shm_transport = false;
+    }
+  }
+
+  if (node_data->shm_transport)
+  {
+    node_data->shm_reader = new StatsShmReader(node_data->name);
+  }
+  else
+  {
+    StatsHost::get_instance()->add_node_data(node_data);
+  }
 }
 
 /** handles requests for Clearwater stats, passing them off to an OIDTree */
@@ -70,68 +84,83 @@ int clearwater_handler(netsnmp_mib_handler* handler,
 
   netsnmp_request_info* request;
   netsnmp_variable_list* var;
+  NodeData* node_data = (NodeData*)reginfo->my_reg_void;
 
-  if (thread_created.load() != true)
+  // The stats host thread can't be started when the plugins are loaded, as
+  // snmpd forks after that, so start it on the first request.
+  StatsHost::get_instance()->start();
+
+  // Stats published through shared memory are read now, as they're needed.
+  if (node_data->shm_reader != NULL)
   {
-    pthread_mutex_lock(&thread_creation_lock);
-    if (thread_created.load() != true)
-    {
-      thread_created.store(true);
-      pthread_t zmq_thread;
-      pthread_create(&zmq_thread, NULL, start_stats, global_node_data);
-    }
-    pthread_mutex_unlock(&thread_creation_lock);
+    node_data->shm_reader->refresh(node_data->stat_to_handler);
   }
-  
-  bool up_to_date = ((long)time(NULL) - last_seen_time) < TIMEOUT_THRESHOLD;
-  if (up_to_date)
+
+  // Each stat is judged on when it was last published, so that one stale
+  // publisher doesn't hide the values of the others.
+  long now = (long)time(NULL);
+
+  for(request = requests; request; request = request->next)
   {
-    for(request = requests; request; request = request->next)
+    OID this_oid(request->requestvb->name, request->requestvb->name_length);
+    StatValue outval;
+    OID outoid;
+    ZMQMessageHandler* stat_handler;
+
+    var = request->requestvb;
+    if (request->processed != 0)
     {
-      OID this_oid(request->requestvb->name, request->requestvb->name_length);
-      int outval;
-      unsigned int retval;
-      OID outoid;
+      continue;
+    }
 
-      var = request->requestvb;
-      if (request->processed != 0)
+    switch (reqinfo->mode)
+    {
+    case MODE_GET:
+      stat_handler = node_data->handler_for_oid(this_oid);
+      if (stat_handler != NULL)
       {
-        continue;
-      }
+        stat_handler->record_access(now);
 
-      switch (reqinfo->mode)
-      {
-      case MODE_GET:
-        if (tree.get(this_oid, outval))
+        if (node_data->lazy_parse)
         {
-          retval = outval;
-          snmp_set_var_typed_value(var, ASN_UNSIGNED,
-                                   (u_char*)&retval,
-                                   sizeof(retval));
+          stat_handler->materialize();
         }
-        break;
-      case MODE_GETNEXT:
-        if (tree.get_next(this_oid, outoid, outval))
+      }
+
+      if ((stat_handler != NULL) && (!stat_handler->is_fresh(now)))
+      {
+        DEBUGMSGTL(("clearwater_handler", "Data out of date for requested OID\n"));
+        netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHINSTANCE);
+      }
+      else if (tree.get(this_oid, outval))
+      {
+        if ((stat_handler != NULL) && (stat_handler->is_stale_marked()))
         {
-          retval = outval;
-          snmp_set_var_objid(var,
-                             outoid.get_ptr(),
-                             outoid.get_len());
-          snmp_set_var_typed_value(var, ASN_UNSIGNED,
-                                   (u_char*)&retval,
-                                   sizeof(retval));
+          DEBUGMSGTL(("clearwater_handler", "Serving stale data while resubscribing\n"));
         }
-        break;
+        set_stat_value(var, stat_handler, this_oid, outval);
+      }
+      break;
+    case MODE_GETNEXT:
+      stat_handler = node_data->handler_for_oid(this_oid);
+      if (stat_handler != NULL)
+      {
+        stat_handler->record_access(now);
+      }
 
-      default:
-        snmp_log(LOG_ERR, "problem encountered in Clearwater handler: unsupported mode %d", reqinfo->mode);
+      if (node_data->get_next(tree, this_oid, now, outoid, outval, stat_handler))
+      {
+        snmp_set_var_objid(var,
+                           outoid.get_ptr(),
+                           outoid.get_len());
+        set_stat_value(var, stat_handler, outoid, outval);
       }
+      break;
+
+    default:
+      snmp_log(LOG_ERR, "problem encountered in Clearwater handler: unsupported mode %d", reqinfo->mode);
     }
   }
-  else
-  {
-    snmp_log(LOG_INFO, "Ignoring request because data out of date (%ld ? %ld)", (long)time(NULL), (long)last_seen_time);
-  }
 
   return SNMP_ERR_NOERROR;
 }
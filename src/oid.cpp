@@ -26,12 +26,12 @@ OID::OID(OID parent_oid, oid x) :
   append(x);
 }
 
-OID::OID(oid* oids_ptr, int len)
+OID::OID(const oid* oids_ptr, int len)
 {
   append(oids_ptr, len);
 }
 
-OID::OID(OID parent_oid, oid* oids_ptr, int len) :
+OID::OID(OID parent_oid, const oid* oids_ptr, int len) :
   _oids(parent_oid._oids)
 {
   append(oids_ptr, len);
@@ -89,13 +89,9 @@ void OID::append(oid x)
   _oids.push_back(x);
 }
 
-void OID::append(oid* oids_ptr, int len)
+void OID::append(const oid* oids_ptr, int len)
 {
-  int i;
-  for (i = 0; i < len; i++)
-  {
-    _oids.push_back(*(oids_ptr+i));
-  }
+  _oids.insert(_oids.end(), oids_ptr, oids_ptr + len);
 }
 
 // Appends the given OID string to this OID
@@ -119,6 +115,17 @@ void OID::append(OIDInetAddr oid_addr)
   _oids.insert(_oids.end(), oid_bytes.begin(), oid_bytes.end());
 }
 
+// Cuts this OID back to its first len elements, keeping its storage so that
+// it can be reused as a scratch buffer for building OIDs with a common prefix
+// e.g. OID("1.2.3.4").truncate(2) is OID("1.2")
+void OID::truncate(int len)
+{
+  if (len < (int)_oids.size())
+  {
+    _oids.resize(len);
+  }
+}
+
 std::string OID::to_string() const
 {
   std::stringstream ss;
@@ -130,8 +137,10 @@ std::string OID::to_string() const
 }
 
 // Debugging tool - prints this OID to stderr
+// LCOV_EXCL_START
 void OID::dump() const
 {
   std::cerr << to_string();
 }
+// LCOV_EXCL_STOP
 
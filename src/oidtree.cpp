@@ -10,14 +10,59 @@
 #include "oidtree.hpp"
 #include <iostream>
 
-static void dump_oidmap(OIDMap m);
+static void dump_oidmap(OIDMap& m);
 
-bool OIDTree::get(OID requested_oid, int& output_result)
+OIDTree::~OIDTree()
 {
-  _map_lock.lock();
+  for (ShardMap::iterator it = _shards.begin(); it != _shards.end(); ++it)
+  {
+    delete it->second;
+    it->second = NULL;
+  }
+}
+
+// OIDs shorter than SHARD_DEPTH are their own shard key.  Those only come up
+// as GETNEXT starting points and subtree roots above a component.
+OID OIDTree::shard_key(const OID& oid)
+{
+  OID key = oid;
+  key.truncate(SHARD_DEPTH);
+  return key;
+}
+
+OIDTree::Shard* OIDTree::get_shard(const OID& oid, bool create)
+{
+  Shard* shard = NULL;
+  OID key = shard_key(oid);
+
+  _shards_lock.lock();
+  ShardMap::iterator it = _shards.find(key);
+  if (it != _shards.end())
+  {
+    shard = it->second;
+  }
+  else if (create)
+  {
+    shard = new Shard();
+    _shards[key] = shard;
+  }
+  _shards_lock.unlock();
+
+  return shard;
+}
+
+bool OIDTree::get(OID requested_oid, StatValue& output_result)
+{
+  Shard* shard = get_shard(requested_oid, false);
+  if (shard == NULL)
+  {
+    return false;
+  }
+
+  shard->lock.lock();
   bool retval = false;
-  OIDMap::iterator oid_location = _oidmap.find(requested_oid);
-  if (oid_location == _oidmap.end())
+  OIDMap::iterator oid_location = shard->oidmap.find(requested_oid);
+  if (oid_location == shard->oidmap.end())
   {
     retval = false;
   }
@@ -26,80 +71,195 @@ bool OIDTree::get(OID requested_oid, int& output_result)
     output_result = oid_location->second;
     retval = true;
   }
-  _map_lock.unlock();
+  shard->lock.unlock();
   return retval;
 }
 
-bool OIDTree::get_next(OID requested_oid, OID& output_oid, int& output_result)
+bool OIDTree::get_next(OID requested_oid, OID& output_oid, StatValue& output_result)
 {
-  _map_lock.lock();
   bool retval = false;
-  OIDMap::iterator oid_location = _oidmap.upper_bound(requested_oid);
 
-  if (oid_location == _oidmap.end())
+  // Shards sort in the same order as their contents, so look for the next
+  // entry in the requested OID's shard, then in each later shard in turn.
+  _shards_lock.lock();
+  for (ShardMap::iterator it = _shards.lower_bound(shard_key(requested_oid));
+       (!retval) && (it != _shards.end());
+       ++it)
   {
-    retval = false;
-  }
-  else
-  {
-    output_oid = oid_location->first;
-    output_result = oid_location->second;
-    retval = true;
+    Shard* shard = it->second;
+    shard->lock.lock();
+    OIDMap::iterator oid_location = shard->oidmap.upper_bound(requested_oid);
+
+    if (oid_location != shard->oidmap.end())
+    {
+      output_oid = oid_location->first;
+      output_result = oid_location->second;
+      retval = true;
+    }
+    shard->lock.unlock();
   }
-  _map_lock.unlock();
+  _shards_lock.unlock();
+
   return retval;
 }
 
 void OIDTree::remove(OID key)
 {
-  _map_lock.lock();
-  _oidmap.erase(key);
-  _map_lock.unlock();
+  Shard* shard = get_shard(key, false);
+  if (shard != NULL)
+  {
+    shard->lock.lock();
+    shard->oidmap.erase(key);
+    shard->lock.unlock();
+  }
 }
 
-void OIDTree::remove_subtree(OID root_oid)
+void OIDTree::remove_subtree_from_shard(Shard* shard, OID root_oid)
 {
-  _map_lock.lock();
+  shard->lock.lock();
 
-  // Create a temporary copy, to avoid iterating over the map we're
-  // deleting items from.
-  OIDMap tmp_oidmap = _oidmap;
-  for(OIDMap::iterator it = tmp_oidmap.begin();
-      it != tmp_oidmap.end();
-      ++it)
+  // Everything in the subtree sorts contiguously from the root, so erase
+  // from there until we leave the subtree.
+  OIDMap::iterator it = shard->oidmap.lower_bound(root_oid);
+  while ((it != shard->oidmap.end()) && (root_oid.subtree_contains(it->first)))
   {
-    OID this_oid = it->first;
-    if (root_oid.subtree_contains(this_oid))
+    it = shard->oidmap.erase(it);
+  }
+  shard->lock.unlock();
+}
+
+void OIDTree::remove_subtree(OID root_oid)
+{
+  if (root_oid.get_len() >= SHARD_DEPTH)
+  {
+    Shard* shard = get_shard(root_oid, false);
+    if (shard != NULL)
+    {
+      remove_subtree_from_shard(shard, root_oid);
+    }
+  }
+  else
+  {
+    // The subtree covers whole shards.
+    std::vector<Shard*> shards;
+    _shards_lock.lock();
+    for (ShardMap::iterator it = _shards.lower_bound(root_oid);
+         (it != _shards.end()) && (root_oid.subtree_contains(it->first));
+         ++it)
     {
-      _oidmap.erase(this_oid);
+      shards.push_back(it->second);
+    }
+    _shards_lock.unlock();
+
+    for (std::vector<Shard*>::iterator it = shards.begin();
+         it != shards.end();
+         ++it)
+    {
+      remove_subtree_from_shard(*it, root_oid);
     }
   }
-  _map_lock.unlock();
 }
 
-void OIDTree::replace_subtree(OID root_oid, OIDMap update)
+void OIDTree::replace_subtree(OID root_oid, const OIDMap& update)
 {
-  _map_lock.lock();
-  remove_subtree(root_oid);
-  _oidmap.insert(update.begin(), update.end());
-
-  _map_lock.unlock();
+  if (root_oid.get_len() >= SHARD_DEPTH)
+  {
+    // The usual case - the subtree is all in one shard, so replace it under
+    // that shard's lock.
+    Shard* shard = get_shard(root_oid, true);
+    shard->lock.lock();
+    remove_subtree_from_shard(shard, root_oid);
+    shard->oidmap.insert(update.begin(), update.end());
+    shard->lock.unlock();
+  }
+  else
+  {
+    remove_subtree(root_oid);
+    apply_changes(update, std::vector<OID>());
+  }
 }
 
+// Sets and removes a batch of entries.  The changes are grouped by shard,
+// and each shard's removes and sets are made under a single lock, so that
+// readers never see a partially applied update to a component's stats.
+// Anything both removed and set ends up set.
+void OIDTree::apply_changes(const OIDMap& sets, const std::vector<OID>& removes)
+{
+  struct ShardChanges
+  {
+    std::vector<const OID*> removes;
+    std::vector<OIDMap::const_iterator> sets;
+  };
+  std::map<OID, ShardChanges, OIDCompare> changes;
+
+  for (std::vector<OID>::const_iterator it = removes.begin();
+       it != removes.end();
+       ++it)
+  {
+    changes[shard_key(*it)].removes.push_back(&(*it));
+  }
+
+  for (OIDMap::const_iterator it = sets.begin();
+       it != sets.end();
+       ++it)
+  {
+    changes[shard_key(it->first)].sets.push_back(it);
+  }
+
+  for (std::map<OID, ShardChanges, OIDCompare>::iterator it = changes.begin();
+       it != changes.end();
+       ++it)
+  {
+    ShardChanges& shard_changes = it->second;
 
-void OIDTree::set(OID key, int value)
+    // There's no need to create a shard just to remove entries from it.
+    Shard* shard = get_shard(it->first, !shard_changes.sets.empty());
+    if (shard == NULL)
+    {
+      continue;
+    }
+
+    shard->lock.lock();
+    for (std::vector<const OID*>::iterator remove = shard_changes.removes.begin();
+         remove != shard_changes.removes.end();
+         ++remove)
+    {
+      shard->oidmap.erase(**remove);
+    }
+
+    for (std::vector<OIDMap::const_iterator>::iterator set = shard_changes.sets.begin();
+         set != shard_changes.sets.end();
+         ++set)
+    {
+      shard->oidmap[(*set)->first] = (*set)->second;
+    }
+    shard->lock.unlock();
+  }
+}
+
+void OIDTree::set(OID key, StatValue value)
 {
-  _map_lock.lock();
-  _oidmap[key] = value;
-  _map_lock.unlock();
+  Shard* shard = get_shard(key, true);
+  shard->lock.lock();
+  shard->oidmap[key] = value;
+  shard->lock.unlock();
 }
 
+// Debugging tool - prints the whole tree to stderr
+// LCOV_EXCL_START
 void OIDTree::dump()
 {
-  dump_oidmap(_oidmap);
+  _shards_lock.lock();
+  for (ShardMap::iterator it = _shards.begin(); it != _shards.end(); ++it)
+  {
+    it->second->lock.lock();
+    dump_oidmap(it->second->oidmap);
+    it->second->lock.unlock();
+  }
+  _shards_lock.unlock();
 }
 
-static void dump_oidmap(OIDMap m) {
+static void dump_oidmap(OIDMap& m) {
   for(OIDMap::iterator it = m.begin();
       it != m.end();
       ++it)
@@ -107,3 +267,4 @@ static void dump_oidmap(OIDMap m) {
     std::cerr << it->first.to_string() << " " << it->second << "\n";
   }
 }
+// LCOV_EXCL_STOP
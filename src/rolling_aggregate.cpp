@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include <cmath>
+#include "rolling_aggregate.hpp"
+
+const int RollingAggregate::WINDOWS[NUM_WINDOWS] = {5, 15, 60};
+
+RollingAggregate::RollingAggregate()
+{
+  reset();
+}
+
+void RollingAggregate::reset()
+{
+  _current_minute = -1;
+  for (int ii = 0; ii < NUM_BUCKETS; ii++)
+  {
+    _buckets[ii].minute = -1;
+  }
+}
+
+void RollingAggregate::add_sample(long now,
+                                  StatValue average,
+                                  StatValue variance,
+                                  StatValue hwm,
+                                  StatValue lwm,
+                                  StatValue count)
+{
+  _current_minute = now / 60;
+  Bucket& bucket = _buckets[_current_minute % NUM_BUCKETS];
+
+  // The bucket is reused every NUM_BUCKETS minutes, so start it afresh if
+  // it's left over from an earlier minute.
+  if (bucket.minute != _current_minute)
+  {
+    bucket.minute = _current_minute;
+    bucket.count = 0;
+    bucket.sum = 0;
+    bucket.sum_of_squares = 0;
+    bucket.hwm = 0;
+    bucket.lwm = 0;
+  }
+
+  // A period with nothing in it has no meaningful average or watermarks.
+  if (count == 0)
+  {
+    return;
+  }
+
+  // Recover the sums from the period's mean and variance, weighted by its
+  // count.
+  double mean = (double)average;
+  bucket.sum += mean * count;
+  bucket.sum_of_squares += ((double)variance + mean * mean) * count;
+
+  if (bucket.count == 0)
+  {
+    bucket.hwm = hwm;
+    bucket.lwm = lwm;
+  }
+  else
+  {
+    bucket.hwm = (hwm > bucket.hwm) ? hwm : bucket.hwm;
+    bucket.lwm = (lwm < bucket.lwm) ? lwm : bucket.lwm;
+  }
+
+  bucket.count += count;
+}
+
+RollingAggregate::Aggregate RollingAggregate::aggregate(int window) const
+{
+  Aggregate result = {0, 0, 0, 0, 0};
+  double sum = 0;
+  double sum_of_squares = 0;
+
+  for (long minute = _current_minute - WINDOWS[window] + 1;
+       (_current_minute >= 0) && (minute <= _current_minute);
+       minute++)
+  {
+    if (minute < 0)
+    {
+      continue;
+    }
+
+    const Bucket& bucket = _buckets[minute % NUM_BUCKETS];
+    if ((bucket.minute != minute) || (bucket.count == 0))
+    {
+      continue;
+    }
+
+    if (result.count == 0)
+    {
+      result.hwm = bucket.hwm;
+      result.lwm = bucket.lwm;
+    }
+    else
+    {
+      result.hwm = (bucket.hwm > result.hwm) ? bucket.hwm : result.hwm;
+      result.lwm = (bucket.lwm < result.lwm) ? bucket.lwm : result.lwm;
+    }
+
+    result.count += bucket.count;
+    sum += bucket.sum;
+    sum_of_squares += bucket.sum_of_squares;
+  }
+
+  if (result.count > 0)
+  {
+    double mean = sum / result.count;
+    double variance = (sum_of_squares / result.count) - (mean * mean);
+    result.average = (StatValue)llround(mean);
+    result.variance = (variance > 0) ? (StatValue)llround(variance) : 0;
+  }
+
+  return result;
+}
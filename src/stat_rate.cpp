@@ -0,0 +1,85 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include <algorithm>
+
+#include "stat_rate.hpp"
+
+StatRate::StatRate(const std::vector<int>& windows) :
+  _head(0),
+  _size(0),
+  _windows(windows),
+  _sums(windows.size(), 0),
+  _counts(windows.size(), 0)
+{
+}
+
+void StatRate::reset()
+{
+  _head = 0;
+  _size = 0;
+  std::fill(_sums.begin(), _sums.end(), 0);
+  std::fill(_counts.begin(), _counts.end(), 0);
+}
+
+std::vector<int> StatRate::default_windows()
+{
+  return {60, 300};
+}
+
+void StatRate::add_sample(long now, StatValue count)
+{
+  // If the ring is full, the oldest sample is about to be overwritten, so
+  // drop it from any window that still includes it.
+  if (_size == MAX_SAMPLES)
+  {
+    const Sample& oldest = _samples[_head];
+    for (size_t ii = 0; ii < _windows.size(); ii++)
+    {
+      if (_counts[ii] == MAX_SAMPLES)
+      {
+        _sums[ii] -= oldest.count;
+        _counts[ii]--;
+      }
+    }
+  }
+  else
+  {
+    _size++;
+  }
+
+  _samples[_head].time = now;
+  _samples[_head].count = count;
+  _head = (_head + 1) % MAX_SAMPLES;
+
+  // Add the new sample to each window, then drop the samples that have aged
+  // out of it.  Each sample is only added to and removed from a window once.
+  for (size_t ii = 0; ii < _windows.size(); ii++)
+  {
+    _sums[ii] += count;
+    _counts[ii]++;
+
+    while (_counts[ii] > 1)
+    {
+      size_t oldest = (_head + MAX_SAMPLES - _counts[ii]) % MAX_SAMPLES;
+      if (now - _samples[oldest].time < _windows[ii])
+      {
+        break;
+      }
+
+      _sums[ii] -= _samples[oldest].count;
+      _counts[ii]--;
+    }
+  }
+}
+
+StatValue StatRate::rate(size_t window) const
+{
+  return (_sums[window] * 1000) / _windows[window];
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include "stat_value.hpp"
+#include <limits>
+
+bool parse_stat_value(const char* start, size_t len, StatValue& value)
+{
+  const StatValue max = std::numeric_limits<StatValue>::max();
+
+  if (len == 0)
+  {
+    return false;
+  }
+
+  StatValue result = 0;
+  for (const char* p = start; p != start + len; p++)
+  {
+    if ((*p < '0') || (*p > '9'))
+    {
+      return false;
+    }
+
+    StatValue digit = *p - '0';
+
+    // Check that result * 10 + digit won't overflow.
+    if (result > (max - digit) / 10)
+    {
+      return false;
+    }
+
+    result = result * 10 + digit;
+  }
+
+  value = result;
+  return true;
+}
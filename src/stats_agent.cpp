@@ -0,0 +1,183 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// Runs the stats plugins as an AgentX sub-agent, rather than loading them into
+// snmpd.  This means that the stats ingest threads and tree locks don't
+// compete with snmpd's request loop, and that the sub-agent can be restarted
+// independently of snmpd.
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <dlfcn.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <signal.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+#include "stats_host.hpp"
+
+static volatile sig_atomic_t keep_running = 1;
+// Signal handler that triggers termination.
+void agent_terminate_handler(int sig)
+{
+  keep_running = 0;
+}
+
+enum OptionTypes
+{
+  OPT_PLUGINS=256+1,
+  OPT_AGENTX_SOCKET,
+  OPT_PING_INTERVAL
+};
+
+const static struct option long_opt[] =
+{
+  { "plugins",                         required_argument, 0, OPT_PLUGINS},
+  { "agentx-socket",                   required_argument, 0, OPT_AGENTX_SOCKET},
+  { "ping-interval",                   required_argument, 0, OPT_PING_INTERVAL},
+  { 0, 0, 0, 0}
+};
+
+static void usage(void)
+{
+    puts("Options:\n"
+         "\n"
+         " --plugins <path>,<path>    Load the specified stats plugin libraries\n"
+         " --agentx-socket <socket>   Connect to the master agent on this socket\n"
+         "                            (default: net-snmp's default AgentX socket)\n"
+         " --ping-interval N          Check the connection to the master agent every\n"
+         "                            N seconds, reconnecting if it has been lost\n"
+         "                            (default: 5)\n"
+        );
+}
+
+// Loads a stats plugin and calls its init function, which registers its
+// handler with the agent.  As with snmpd's dlmod, the init function for
+// <path>/<name>.so is init_<name>.
+static bool load_plugin(const std::string& path)
+{
+  void* lib = dlopen(path.c_str(), RTLD_NOW);
+  if (lib == NULL)
+  {
+    snmp_log(LOG_ERR, "Failed to load stats plugin %s: %s", path.c_str(), dlerror());
+    return false;
+  }
+
+  std::vector<char> path_buf(path.begin(), path.end());
+  path_buf.push_back('\0');
+  std::string name = basename(path_buf.data());
+  if (boost::algorithm::ends_with(name, ".so"))
+  {
+    name.resize(name.length() - 3);
+  }
+
+  std::string init_name = "init_" + name;
+  void (*init_fn)() = (void (*)())dlsym(lib, init_name.c_str());
+  if (init_fn == NULL)
+  {
+    snmp_log(LOG_ERR, "Stats plugin %s has no %s function", path.c_str(), init_name.c_str());
+    dlclose(lib);
+    return false;
+  }
+
+  init_fn();
+  snmp_log(LOG_INFO, "Loaded stats plugin %s", path.c_str());
+  return true;
+}
+
+int main (int argc, char **argv)
+{
+  std::vector<std::string> plugins;
+  char* agentx_socket = NULL;
+  int ping_interval = 5;
+  int c;
+  int optind;
+
+  opterr = 0;
+  while ((c = getopt_long(argc, argv, "", long_opt, &optind)) != -1)
+  {
+    switch (c)
+      {
+      case OPT_PLUGINS:
+        {
+          std::string plugin_list = optarg;
+          boost::split(plugins, plugin_list, boost::is_any_of(","), boost::token_compress_on);
+          break;
+        }
+      case OPT_AGENTX_SOCKET:
+        agentx_socket = optarg;
+        break;
+      case OPT_PING_INTERVAL:
+        ping_interval = atoi(optarg);
+        break;
+      default:
+        usage();
+        abort();
+      }
+  }
+
+  snmp_enable_syslog_ident("clearwater-stats", LOG_DAEMON);
+
+  // Run as an AgentX sub-agent.  If the master agent goes away (e.g. because
+  // snmpd is restarted) the ping notices and we reconnect.
+  netsnmp_ds_set_boolean(NETSNMP_DS_APPLICATION_ID, NETSNMP_DS_AGENT_ROLE, 1);
+  netsnmp_ds_set_int(NETSNMP_DS_APPLICATION_ID,
+                     NETSNMP_DS_AGENT_AGENTX_PING_INTERVAL,
+                     ping_interval);
+  if (agentx_socket != NULL)
+  {
+    netsnmp_ds_set_string(NETSNMP_DS_APPLICATION_ID,
+                          NETSNMP_DS_AGENT_X_SOCKET,
+                          agentx_socket);
+  }
+
+  init_agent("clearwater-stats");
+
+  int loaded = 0;
+  for (std::vector<std::string>::iterator it = plugins.begin();
+       it != plugins.end();
+       ++it)
+  {
+    if ((!it->empty()) && (load_plugin(*it)))
+    {
+      loaded++;
+    }
+  }
+
+  if (loaded == 0)
+  {
+    snmp_log(LOG_ERR, "No stats plugins loaded - shutting down");
+    return 1;
+  }
+
+  init_snmp("clearwater-stats");
+
+  // We don't fork after this point, so start listening for stats straight
+  // away rather than waiting for the first request.
+  StatsHost::get_instance()->start();
+
+  signal(SIGTERM, agent_terminate_handler);
+  signal(SIGINT, agent_terminate_handler);
+
+  snmp_log(LOG_INFO, "Stats agent has started with %d plugins", loaded);
+
+  while (keep_running)
+  {
+    agent_check_and_process(1);
+  }
+
+  snmp_shutdown("clearwater-stats");
+  return 0;
+}
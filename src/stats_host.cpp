@@ -0,0 +1,159 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include <zmq.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+#include "stats_host.hpp"
+
+StatsHost* StatsHost::get_instance()
+{
+  static StatsHost instance;
+  return &instance;
+}
+
+void StatsHost::add_node_data(NodeData* node_data)
+{
+  std::lock_guard<std::mutex> guard(_pending_lock);
+  _pending.push_back(node_data);
+}
+
+void StatsHost::start()
+{
+  bool started = false;
+  if (_started.compare_exchange_strong(started, true))
+  {
+    if (pthread_create(&_thread, NULL, run_thread, this) != 0)
+    {
+      perror("pthread_create");
+      _started.store(false);
+    }
+    else
+    {
+      // The thread exits if polling fails, to be restarted by the next
+      // request, so nothing waits for it.
+      pthread_detach(_thread);
+    }
+  }
+}
+
+void* StatsHost::run_thread(void* host_ptr)
+{
+  ((StatsHost*)host_ptr)->run();
+  return NULL; // Never hit
+}
+
+// Creates and connects a listener for each newly added node data.
+void StatsHost::create_listeners(void* ctx, std::vector<ZMQListener*>& listeners)
+{
+  std::vector<NodeData*> pending;
+  {
+    std::lock_guard<std::mutex> guard(_pending_lock);
+    pending.swap(_pending);
+  }
+
+  for (std::vector<NodeData*>::iterator it = pending.begin();
+       it != pending.end();
+       ++it)
+  {
+    ZMQListener* listener = new ZMQListener(*it, ctx);
+    if (listener->connect_and_subscribe())
+    {
+      listeners.push_back(listener);
+    }
+    else
+    {
+      snmp_log(LOG_ERR, "Failed to subscribe to stats for %s", (*it)->name.c_str());
+      delete listener;
+    }
+  }
+}
+
+// Main loop of the host thread - poll every plugin's socket for ZMQ publish
+// messages and pass each one to the listener that owns the socket.  We wake
+// up periodically even if nothing is published, so that we can drop or
+// restore subscriptions as the NMS stops or starts polling stats.
+void StatsHost::run()
+{
+  void* ctx = zmq_ctx_new();
+  if (ctx == NULL)
+  {
+    perror("zmq_ctx_new");
+    _started.store(false);
+    return;
+  }
+
+  std::vector<ZMQListener*> listeners;
+  std::vector<zmq_pollitem_t> items;
+
+  while (1)
+  {
+    create_listeners(ctx, listeners);
+
+    items.resize(listeners.size());
+    for (size_t ii = 0; ii < listeners.size(); ii++)
+    {
+      listeners[ii]->update_subscriptions();
+
+      items[ii].socket = listeners[ii]->socket();
+      items[ii].fd = 0;
+      items[ii].events = ZMQ_POLLIN;
+      items[ii].revents = 0;
+    }
+
+    int rc = zmq_poll(items.data(), (int)items.size(), POLL_INTERVAL_MS);
+    if (rc == -1)
+    {
+      if (errno == EINTR)
+      {
+        // Ignore possible errors caused by a syscall being interrupted by a signal.
+        continue;
+      }
+      perror("zmq_poll");
+      snmp_log(LOG_ERR, "Failed to poll for stats - the host thread will be restarted by the next request");
+      break;
+    }
+
+    for (size_t ii = 0; (rc > 0) && (ii < listeners.size()); ii++)
+    {
+      if ((items[ii].revents & ZMQ_POLLIN) &&
+          (!listeners[ii]->handle_msg()))
+      {
+        // The socket's broken, so stop listening on it, but keep serving
+        // the other plugins.
+        snmp_log(LOG_ERR, "Stopped listening for stats from %s", listeners[ii]->name().c_str());
+        delete listeners[ii];
+        listeners[ii] = NULL;
+      }
+    }
+
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), (ZMQListener*)NULL),
+                    listeners.end());
+  }
+
+  // Hand the node data back, so that the next request starts a new thread
+  // which subscribes to the stats again.
+  for (std::vector<ZMQListener*>::iterator it = listeners.begin();
+       it != listeners.end();
+       ++it)
+  {
+    add_node_data((*it)->node_data());
+    delete *it;
+  }
+
+  if (zmq_ctx_destroy(ctx) != 0)
+  {
+    perror("zmq_ctx_destroy");
+  }
+
+  _started.store(false);
+}
@@ -0,0 +1,342 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "stats_shm.hpp"
+
+std::string StatsShm::path(const std::string& directory, const std::string& name)
+{
+  return directory + "/" + name + ".shm";
+}
+
+// Creates a directory and any missing parents.
+static bool make_directory(const std::string& directory)
+{
+  size_t pos = 0;
+  do
+  {
+    pos = directory.find('/', pos + 1);
+    std::string dir = directory.substr(0, pos);
+    if ((mkdir(dir.c_str(), 0755) != 0) && (errno != EEXIST))
+    {
+      perror("mkdir");
+      return false;
+    }
+  }
+  while (pos != std::string::npos);
+
+  return true;
+}
+
+StatsShmWriter::~StatsShmWriter()
+{
+  if (_region != NULL)
+  {
+    munmap(_region, sizeof(StatsShm::Region));
+    _region = NULL;
+  }
+}
+
+// Creates a new, empty file for this component's stats.  The file is built
+// under a temporary name and then renamed into place, so readers never see
+// it half initialized.
+bool StatsShmWriter::open()
+{
+  if (!make_directory(_directory))
+  {
+    return false;
+  }
+
+  std::string path = StatsShm::path(_directory, _name);
+  std::string tmp_path = path + ".tmp";
+
+  int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1)
+  {
+    // LCOV_EXCL_START
+    perror("open");
+    return false;
+    // LCOV_EXCL_STOP
+  }
+
+  if (ftruncate(fd, sizeof(StatsShm::Region)) != 0)
+  {
+    // LCOV_EXCL_START
+    perror("ftruncate");
+    close(fd);
+    return false;
+    // LCOV_EXCL_STOP
+  }
+
+  void* addr = mmap(NULL,
+                    sizeof(StatsShm::Region),
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED,
+                    fd,
+                    0);
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    // LCOV_EXCL_START
+    perror("mmap");
+    return false;
+    // LCOV_EXCL_STOP
+  }
+
+  // The file is zero filled, so all the slots are empty.
+  _region = (StatsShm::Region*)addr;
+  _region->magic = StatsShm::MAGIC;
+  _region->version = StatsShm::VERSION;
+  _region->num_slots.store(0, std::memory_order_release);
+
+  if (rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    // LCOV_EXCL_START
+    perror("rename");
+    return false;
+    // LCOV_EXCL_STOP
+  }
+
+  return true;
+}
+
+// Finds the slot for a stat, allocating one if this is the first time it's
+// been published.  Slots are never freed.
+StatsShm::Slot* StatsShmWriter::find_slot(const std::string& stat)
+{
+  uint32_t num_slots = _region->num_slots.load(std::memory_order_relaxed);
+  for (uint32_t ii = 0; ii < num_slots; ii++)
+  {
+    if (strncmp(_region->slots[ii].name, stat.c_str(), StatsShm::MAX_NAME_LEN) == 0)
+    {
+      return &_region->slots[ii];
+    }
+  }
+
+  if ((num_slots >= StatsShm::MAX_STATS) ||
+      (stat.length() >= StatsShm::MAX_NAME_LEN))
+  {
+    return NULL;
+  }
+
+  // Fill in the name before publishing the slot to readers.
+  StatsShm::Slot* slot = &_region->slots[num_slots];
+  strncpy(slot->name, stat.c_str(), StatsShm::MAX_NAME_LEN - 1);
+  _region->num_slots.store(num_slots + 1, std::memory_order_release);
+  return slot;
+}
+
+bool StatsShmWriter::publish(const std::string& stat,
+                             const std::vector<StatValue>& values)
+{
+  if ((_region == NULL) || (values.size() > StatsShm::MAX_VALUES))
+  {
+    return false;
+  }
+
+  StatsShm::Slot* slot = find_slot(stat);
+  if (slot == NULL)
+  {
+    return false;
+  }
+
+  uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+  slot->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->num_values = values.size();
+  slot->publish_time = time(NULL);
+  std::copy(values.begin(), values.end(), slot->values);
+
+  slot->seq.store(seq + 2, std::memory_order_release);
+  return true;
+}
+
+StatsShmReader::~StatsShmReader()
+{
+  unmap();
+}
+
+void StatsShmReader::unmap()
+{
+  if (_region != NULL)
+  {
+    munmap(_region, sizeof(StatsShm::Region));
+    _region = NULL;
+  }
+  _inode = 0;
+  _slot_indices.clear();
+  _applied_seqs.clear();
+}
+
+// Maps the component's stats file if it isn't already mapped, or if the
+// publisher has replaced it since we mapped it.
+void StatsShmReader::check_mapping(long now)
+{
+  if ((_region != NULL) && ((now - _last_check_time) < REMAP_CHECK_INTERVAL))
+  {
+    return;
+  }
+  _last_check_time = now;
+
+  std::string path = StatsShm::path(_directory, _name);
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+  {
+    // The publisher isn't running, so let the stats expire.
+    unmap();
+    return;
+  }
+
+  if ((_region != NULL) && (st.st_ino == _inode))
+  {
+    return;
+  }
+
+  unmap();
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    // LCOV_EXCL_START - only if the file's removed after we checked it
+    return;
+    // LCOV_EXCL_STOP
+  }
+
+  if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(StatsShm::Region)))
+  {
+    close(fd);
+    return;
+  }
+
+  void* addr = mmap(NULL, sizeof(StatsShm::Region), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    // LCOV_EXCL_START
+    perror("mmap");
+    return;
+    // LCOV_EXCL_STOP
+  }
+
+  StatsShm::Region* region = (StatsShm::Region*)addr;
+  if ((region->magic != StatsShm::MAGIC) ||
+      (region->version != StatsShm::VERSION))
+  {
+    snmp_log(LOG_ERR,
+             "Ignoring stats file %s with unsupported format %u",
+             path.c_str(),
+             region->version);
+    munmap(addr, sizeof(StatsShm::Region));
+    return;
+  }
+
+  _region = region;
+  _inode = st.st_ino;
+}
+
+// Copies a consistent snapshot of a slot.  Returns false if the slot is
+// empty, or if the publisher kept updating it while we tried to read it.
+bool StatsShmReader::read_slot(const StatsShm::Slot& slot,
+                               uint32_t& seq,
+                               long& publish_time,
+                               std::vector<StatValue>& values)
+{
+  for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+  {
+    uint32_t start_seq = slot.seq.load(std::memory_order_acquire);
+    if (start_seq & 1)
+    {
+      continue;
+    }
+
+    uint32_t num_values = slot.num_values;
+    if (num_values > StatsShm::MAX_VALUES)
+    {
+      num_values = StatsShm::MAX_VALUES;
+    }
+    publish_time = (long)slot.publish_time;
+    values.assign(slot.values, slot.values + num_values);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == start_seq)
+    {
+      seq = start_seq;
+      return (seq != 0);
+    }
+  }
+
+  return false;
+}
+
+void StatsShmReader::refresh(std::map<std::string, ZMQMessageHandler*>& stat_to_handler)
+{
+  std::lock_guard<std::mutex> guard(_lock);
+
+  check_mapping((long)time(NULL));
+  if (_region == NULL)
+  {
+    return;
+  }
+
+  std::vector<StatValue> values;
+  for (std::map<std::string, ZMQMessageHandler*>::iterator it = stat_to_handler.begin();
+       it != stat_to_handler.end();
+       ++it)
+  {
+    std::map<std::string, int>::iterator index = _slot_indices.find(it->first);
+    if (index == _slot_indices.end())
+    {
+      // Look for the stat among the slots the publisher has filled in.
+      uint32_t num_slots = _region->num_slots.load(std::memory_order_acquire);
+      for (uint32_t ii = 0; (ii < num_slots) && (ii < StatsShm::MAX_STATS); ii++)
+      {
+        if (strncmp(_region->slots[ii].name,
+                    it->first.c_str(),
+                    StatsShm::MAX_NAME_LEN) == 0)
+        {
+          index = _slot_indices.insert(std::make_pair(it->first, (int)ii)).first;
+          break;
+        }
+      }
+
+      if (index == _slot_indices.end())
+      {
+        continue;
+      }
+    }
+
+    uint32_t seq;
+    long publish_time;
+    if (!read_slot(_region->slots[index->second], seq, publish_time, values))
+    {
+      continue;
+    }
+
+    it->second->update_last_seen_time(publish_time);
+
+    // Only parse the values into the tree if they've changed since we last
+    // did so.
+    std::map<std::string, uint32_t>::iterator applied = _applied_seqs.find(it->first);
+    if ((applied == _applied_seqs.end()) || (applied->second != seq))
+    {
+      it->second->handle_values(values);
+      _applied_seqs[it->first] = seq;
+    }
+  }
+}
@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) Metaswitch Networks 2016
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+// A stand-in for a component publishing its stats through shared memory, for
+// testing the stats plugins' shared memory transport.  For example
+//
+//   cw_stats_shm_publisher --name=memento http_latency_us=100,20,50,200,7
+//
+// publishes the given values (the fields that would follow "OK" in a ZMQ
+// publish), then republishes them every interval so that they stay fresh.
+
+#include <getopt.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+#include "stats_shm.hpp"
+
+enum OptionTypes
+{
+  OPT_NAME=256+1,
+  OPT_INTERVAL
+};
+
+const static struct option long_opt[] =
+{
+  { "name",                            required_argument, 0, OPT_NAME},
+  { "interval",                        required_argument, 0, OPT_INTERVAL},
+  { 0, 0, 0, 0}
+};
+
+static void usage(void)
+{
+    puts("Usage: cw_stats_shm_publisher [options] <stat>=<value>,<value>,...\n"
+         "\n"
+         "Options:\n"
+         "\n"
+         " --name <name>              Name of the component to publish stats for\n"
+         " --interval N               Republish the stats every N seconds, or just\n"
+         "                            once if N is 0 (default: 5)\n"
+        );
+}
+
+int main(int argc, char** argv)
+{
+  std::string name;
+  int interval = 5;
+  int c;
+  int optind_unused;
+
+  opterr = 0;
+  while ((c = getopt_long(argc, argv, "", long_opt, &optind_unused)) != -1)
+  {
+    switch (c)
+      {
+      case OPT_NAME:
+        name = optarg;
+        break;
+      case OPT_INTERVAL:
+        interval = atoi(optarg);
+        break;
+      default:
+        usage();
+        return 1;
+      }
+  }
+
+  if (name.empty() || (optind >= argc))
+  {
+    usage();
+    return 1;
+  }
+
+  std::vector<std::pair<std::string, std::vector<StatValue> > > stats;
+  for (int ii = optind; ii < argc; ii++)
+  {
+    std::string arg = argv[ii];
+    size_t equals = arg.find('=');
+    if (equals == std::string::npos)
+    {
+      usage();
+      return 1;
+    }
+
+    std::vector<std::string> fields;
+    std::string field_list = arg.substr(equals + 1);
+    boost::split(fields, field_list, boost::is_any_of(","));
+
+    std::vector<StatValue> values(fields.size());
+    for (size_t jj = 0; jj < fields.size(); jj++)
+    {
+      if (!parse_stat_value(fields[jj], values[jj]))
+      {
+        fprintf(stderr, "Invalid value '%s' for %s\n", fields[jj].c_str(), arg.c_str());
+        return 1;
+      }
+    }
+
+    stats.push_back(std::make_pair(arg.substr(0, equals), values));
+  }
+
+  StatsShmWriter writer(name);
+  if (!writer.open())
+  {
+    return 1;
+  }
+
+  do
+  {
+    for (size_t ii = 0; ii < stats.size(); ii++)
+    {
+      if (!writer.publish(stats[ii].first, stats[ii].second))
+      {
+        fprintf(stderr, "Failed to publish %s\n", stats[ii].first.c_str());
+      }
+    }
+  }
+  while ((interval > 0) && (sleep(interval) == 0));
+
+  return 0;
+}
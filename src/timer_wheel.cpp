@@ -0,0 +1,334 @@
+/**
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+*/
+
+#include "timer_wheel.hpp"
+#include "utils.h"
+
+void TimerList::push_back(WheelTimer* timer)
+{
+  timer->_list = this;
+  timer->_prev = tail;
+  timer->_next = nullptr;
+
+  if (tail != nullptr)
+  {
+    tail->_next = timer;
+  }
+  else
+  {
+    head = timer;
+  }
+
+  tail = timer;
+}
+
+void TimerList::remove(WheelTimer* timer)
+{
+  if (timer->_prev != nullptr)
+  {
+    timer->_prev->_next = timer->_next;
+  }
+  else
+  {
+    head = timer->_next;
+  }
+
+  if (timer->_next != nullptr)
+  {
+    timer->_next->_prev = timer->_prev;
+  }
+  else
+  {
+    tail = timer->_prev;
+  }
+
+  timer->_list = nullptr;
+  timer->_prev = nullptr;
+  timer->_next = nullptr;
+}
+
+void TimerList::splice_onto(TimerList& other)
+{
+  if (head == nullptr)
+  {
+    return;
+  }
+
+  for (WheelTimer* timer = head; timer != nullptr; timer = timer->_next)
+  {
+    timer->_list = &other;
+  }
+
+  if (other.tail != nullptr)
+  {
+    other.tail->_next = head;
+    head->_prev = other.tail;
+  }
+  else
+  {
+    other.head = head;
+  }
+
+  other.tail = tail;
+  head = nullptr;
+  tail = nullptr;
+}
+
+TimerWheel::TimerWheel() :
+  _now(0),
+  _count(0),
+  _inner_count(0)
+{
+}
+
+void TimerWheel::insert(WheelTimer* timer)
+{
+  if (timer->_wheel == this)
+  {
+    reschedule(timer);
+    return;
+  }
+
+  if (_count == 0)
+  {
+    // Nothing has been moving the wheel on while it's been empty, so catch
+    // up with the current time before placing the timer.
+    uint64_t now = Utils::get_time();
+    if (now > _now)
+    {
+      _now = now;
+    }
+  }
+
+  timer->_wheel = this;
+  _count++;
+  add(timer);
+}
+
+void TimerWheel::reschedule(WheelTimer* timer)
+{
+  if (timer->_wheel != this)
+  {
+    insert(timer);
+    return;
+  }
+
+  TimerList* list = timer->_list;
+  if ((list >= _inner) && (list < _inner + INNER_SLOTS))
+  {
+    _inner_count--;
+  }
+
+  list->remove(timer);
+  add(timer);
+}
+
+bool TimerWheel::remove(WheelTimer* timer)
+{
+  if (timer->_wheel != this)
+  {
+    return false;
+  }
+
+  TimerList* list = timer->_list;
+  if ((list >= _inner) && (list < _inner + INNER_SLOTS))
+  {
+    _inner_count--;
+  }
+
+  list->remove(timer);
+  timer->_wheel = nullptr;
+  _count--;
+  return true;
+}
+
+void TimerWheel::add(WheelTimer* timer)
+{
+  uint64_t pop_time = timer->get_pop_time();
+
+  if (pop_time <= _now)
+  {
+    _ready.push_back(timer);
+  }
+  else if (pop_time - _now < INNER_SLOTS)
+  {
+    _inner[pop_time & (INNER_SLOTS - 1)].push_back(timer);
+    _inner_count++;
+  }
+  else if (pop_time - _now < (uint64_t)INNER_SLOTS * OUTER_SLOTS)
+  {
+    _outer[(pop_time >> INNER_BITS) & (OUTER_SLOTS - 1)].push_back(timer);
+  }
+  else
+  {
+    _overflow.push_back(timer);
+  }
+}
+
+void TimerWheel::readd_all(TimerList& list)
+{
+  WheelTimer* timer = list.head;
+  list.head = nullptr;
+  list.tail = nullptr;
+
+  while (timer != nullptr)
+  {
+    WheelTimer* next = timer->_next;
+    timer->_prev = nullptr;
+    timer->_next = nullptr;
+    add(timer);
+    timer = next;
+  }
+}
+
+void TimerWheel::advance(uint64_t now)
+{
+  if (now <= _now)
+  {
+    return;
+  }
+
+  if (_count == 0)
+  {
+    _now = now;
+    return;
+  }
+
+  const uint64_t inner_mask = INNER_SLOTS - 1;
+  const uint64_t overflow_mask = ((uint64_t)INNER_SLOTS * OUTER_SLOTS) - 1;
+
+  while (_now < now)
+  {
+    if (_inner_count == 0)
+    {
+      // Nothing can pop before the end of the current inner rotation, so
+      // skip straight to it.
+      uint64_t rotation_end = _now | inner_mask;
+      if (rotation_end >= now)
+      {
+        _now = now;
+        break;
+      }
+
+      _now = rotation_end;
+    }
+
+    _now++;
+
+    // At the start of each outer rotation, pull in any overflow timers that
+    // are now in range, and at the start of each inner rotation cascade the
+    // next outer slot into the inner wheel.
+    if ((_now & overflow_mask) == 0)
+    {
+      readd_all(_overflow);
+    }
+
+    if ((_now & inner_mask) == 0)
+    {
+      readd_all(_outer[(_now >> INNER_BITS) & (OUTER_SLOTS - 1)]);
+    }
+
+    TimerList& slot = _inner[_now & inner_mask];
+    for (WheelTimer* timer = slot.head; timer != nullptr; timer = timer->_next)
+    {
+      _inner_count--;
+    }
+    slot.splice_onto(_ready);
+  }
+}
+
+WheelTimer* TimerWheel::get_next_due_timer(uint64_t now)
+{
+  advance(now);
+  return _ready.head;
+}
+
+uint64_t TimerWheel::get_next_check_time()
+{
+  if (_count == 0)
+  {
+    return UINT64_MAX;
+  }
+
+  if (!_ready.empty())
+  {
+    return _now;
+  }
+
+  uint64_t check_time = UINT64_MAX;
+
+  if (_inner_count > 0)
+  {
+    for (uint64_t time = _now + 1; time < _now + INNER_SLOTS; time++)
+    {
+      if (!_inner[time & (INNER_SLOTS - 1)].empty())
+      {
+        check_time = time;
+        break;
+      }
+    }
+  }
+
+  // Timers in the outer wheel can't pop before their slot is cascaded at the
+  // start of an inner rotation.  That can be before the first inner timer
+  // pops, if it's in the next rotation.
+  uint64_t rotation = _now >> INNER_BITS;
+  for (uint64_t next = rotation + 1;
+       (next <= rotation + OUTER_SLOTS) && ((next << INNER_BITS) < check_time);
+       next++)
+  {
+    if (!_outer[next & (OUTER_SLOTS - 1)].empty())
+    {
+      check_time = next << INNER_BITS;
+      break;
+    }
+  }
+
+  // Overflow timers are pulled in at the start of the next outer rotation,
+  // and can't pop before then.
+  if (!_overflow.empty())
+  {
+    uint64_t pull_in_time = ((_now >> (INNER_BITS + OUTER_BITS)) + 1) <<
+                                                     (INNER_BITS + OUTER_BITS);
+    if (pull_in_time < check_time)
+    {
+      check_time = pull_in_time;
+    }
+  }
+
+  return check_time;
+}
+
+void TimerWheel::clear()
+{
+  TimerList* lists[] = {&_ready, &_overflow};
+  for (TimerList* list : lists)
+  {
+    while (!list->empty())
+    {
+      remove(list->head);
+    }
+  }
+
+  for (int ii = 0; ii < INNER_SLOTS; ii++)
+  {
+    while (!_inner[ii].empty())
+    {
+      remove(_inner[ii].head);
+    }
+  }
+
+  for (int ii = 0; ii < OUTER_SLOTS; ii++)
+  {
+    while (!_outer[ii].empty())
+    {
+      remove(_outer[ii].head);
+    }
+  }
+}
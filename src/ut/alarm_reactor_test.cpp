@@ -0,0 +1,135 @@
+/**
+ * @file alarm_reactor_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "alarm_reactor.hpp"
+#include "utils.h"
+
+#include "fakelogger.h"
+
+class AlarmReactorTest : public ::testing::Test
+{
+public:
+  AlarmReactorTest()
+  {
+    _snmp_notifications.insert(NotificationType::RFC3877);
+
+    _alarm_table_defs = new AlarmTableDefs();
+    _alarm_scheduler = new AlarmScheduler(_alarm_table_defs,
+                                          _snmp_notifications,
+                                          "hostname1",
+                                          _lock,
+                                          false);
+    _alarm_req_listener = new AlarmReqListener(_alarm_scheduler);
+    _alarm_reactor = new AlarmReactor(_alarm_scheduler,
+                                      _alarm_req_listener,
+                                      _lock);
+
+    EXPECT_TRUE(_alarm_req_listener->open());
+    EXPECT_TRUE(_alarm_reactor->init());
+  }
+
+  virtual ~AlarmReactorTest()
+  {
+    delete _alarm_reactor; _alarm_reactor = NULL;
+    _alarm_req_listener->close();
+    delete _alarm_req_listener; _alarm_req_listener = NULL;
+    delete _alarm_scheduler; _alarm_scheduler = NULL;
+    delete _alarm_table_defs; _alarm_table_defs = NULL;
+  }
+
+  // Returns the time (in ms) the timer is set to next expire in, or 0 if it
+  // isn't armed.
+  uint64_t timer_expires_in()
+  {
+    struct itimerspec its;
+    EXPECT_EQ(0, timerfd_gettime(_alarm_reactor->_timer_fd, &its));
+    return (its.it_value.tv_sec * 1000) + (its.it_value.tv_nsec / 1000000);
+  }
+
+private:
+  std::set<NotificationType> _snmp_notifications;
+  CapturingTestLogger _log;
+  AlarmTableDefs* _alarm_table_defs;
+  pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+  AlarmScheduler* _alarm_scheduler;
+  AlarmReqListener* _alarm_req_listener;
+  AlarmReactor* _alarm_reactor;
+};
+
+// Check that the loop stops when asked to.
+TEST_F(AlarmReactorTest, RunAndStop)
+{
+  _alarm_reactor->stop();
+  _alarm_reactor->run();
+
+  EXPECT_TRUE(_log.contains("Alarm agent event loop stopping"));
+}
+
+// Check that the timer is armed for the time given, and disarmed when
+// there's nothing to wait for.
+TEST_F(AlarmReactorTest, ArmAndDisarmTimer)
+{
+  EXPECT_EQ(0u, timer_expires_in());
+
+  uint64_t check_time = Utils::get_time() + 60000;
+  _alarm_reactor->arm_timer(check_time);
+  EXPECT_EQ(check_time, _alarm_reactor->_timer_armed_for);
+  EXPECT_GT(timer_expires_in(), 0u);
+  EXPECT_LE(timer_expires_in(), 60000u);
+
+  _alarm_reactor->arm_timer(UINT64_MAX);
+  EXPECT_EQ(0u, _alarm_reactor->_timer_armed_for);
+  EXPECT_EQ(0u, timer_expires_in());
+
+  // Disarming a timer that isn't armed does nothing.
+  _alarm_reactor->arm_timer(UINT64_MAX);
+  EXPECT_EQ(0u, _alarm_reactor->_timer_armed_for);
+  EXPECT_EQ(0u, timer_expires_in());
+}
+
+// Check that the timer isn't reset if it's already armed for the time given.
+TEST_F(AlarmReactorTest, ArmTimerUnchanged)
+{
+  uint64_t check_time = Utils::get_time() + 60000;
+  _alarm_reactor->arm_timer(check_time);
+
+  // Disarm the timer behind the reactor's back, so we can tell whether
+  // arming it again for the same time touches it.
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  EXPECT_EQ(0, timerfd_settime(_alarm_reactor->_timer_fd, 0, &its, NULL));
+
+  _alarm_reactor->arm_timer(check_time);
+  EXPECT_EQ(0u, timer_expires_in());
+
+  _alarm_reactor->arm_timer(check_time + 1000);
+  EXPECT_GT(timer_expires_in(), 0u);
+}
+
+// Check that a check time of 0 (which would disarm the timer) arms it to pop
+// straight away.
+TEST_F(AlarmReactorTest, ArmTimerForPast)
+{
+  _alarm_reactor->arm_timer(0);
+  EXPECT_EQ(1u, _alarm_reactor->_timer_armed_for);
+
+  uint64_t expirations = 0;
+  EXPECT_EQ((ssize_t)sizeof(expirations),
+            read(_alarm_reactor->_timer_fd, &expirations, sizeof(expirations)));
+  EXPECT_EQ(1u, expirations);
+}
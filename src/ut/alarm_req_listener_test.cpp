@@ -40,10 +40,57 @@ using ::testing::MatcherInterface;
 using ::testing::MatchResultListener;
 using ::testing::SaveArg;
 using ::testing::Invoke;
+using ::testing::Assign;
 
 static const char issuer1[] = "sprout";
 static const char issuer2[] = "homestead";
 
+// Fake zmq_getsockopt results for ZMQ_RCVMORE, so that the listener reads a
+// whole ROUTER envelope from the mocked socket.
+static int more_frames(void* s, int option, void* optval, size_t* optvallen)
+{
+  *(int*)optval = 1;
+  return 0;
+}
+
+static int last_frame(void* s, int option, void* optval, size_t* optvallen)
+{
+  *(int*)optval = 0;
+  return 0;
+}
+
+// Fake zmq_getsockopt results for ZMQ_EVENTS.
+static int readable(void* s, int option, void* optval, size_t* optvallen)
+{
+  *(int*)optval = ZMQ_POLLIN;
+  return 0;
+}
+
+static int not_readable(void* s, int option, void* optval, size_t* optvallen)
+{
+  *(int*)optval = 0;
+  return 0;
+}
+
+// Fake zmq_msg_recv result when there's nothing to read without blocking.
+static int would_block(zmq_msg_t* msg, void* s, int flags)
+{
+  errno = EAGAIN;
+  return -1;
+}
+
+// Records the last frame of the reply sent by the listener.
+static std::string last_reply;
+
+static int save_reply(void* s, const void* buf, size_t len, int flags)
+{
+  if ((flags & ZMQ_SNDMORE) == 0)
+  {
+    last_reply.assign((const char*)buf, len);
+  }
+  return len;
+}
+
 class AlarmReqListenerTest : public ::testing::Test
 {
 public:
@@ -128,6 +175,60 @@ private:
   AlarmReqListener* _alarm_req_listener;
 };
 
+// Listener that's driven from the calling thread (as by the AlarmReactor)
+// rather than its own threads.
+class AlarmReqListenerInlineTest : public ::testing::Test
+{
+public:
+  AlarmReqListenerInlineTest()
+  {
+    _snmp_notifications.insert(NotificationType::RFC3877);
+
+    cwtest_completely_control_time();
+
+    _alarm_table_defs = new AlarmTableDefs();
+    _alarm_scheduler = new MockAlarmScheduler(_alarm_table_defs, _snmp_notifications, _lock);
+    _alarm_req_listener = new AlarmReqListener(_alarm_scheduler);
+    _alarm_req_listener->open();
+    _alarm_manager = new AlarmManager();
+
+    // Wait until the AlarmReRaiser is waiting before we start (so it doesn't
+    // try and reraise any alarms unexpectedly).
+    _alarm_manager->alarm_re_raiser()->_condition->block_till_waiting();
+  }
+
+  virtual ~AlarmReqListenerInlineTest()
+  {
+    delete _alarm_manager; _alarm_manager = NULL;
+    _alarm_req_listener->close();
+    delete _alarm_req_listener; _alarm_req_listener = NULL;
+    delete _alarm_scheduler; _alarm_scheduler = NULL;
+    delete _alarm_table_defs; _alarm_table_defs = NULL;
+
+    cwtest_reset_time();
+  }
+
+  // Handles requests as they arrive until the flag is set, giving up after
+  // a second.
+  void handle_requests_until(const bool& done)
+  {
+    for (int ii = 0; (ii < 100) && (!done); ii++)
+    {
+      _alarm_req_listener->handle_ready_requests();
+      usleep(10000);
+    }
+  }
+
+private:
+  std::set<NotificationType> _snmp_notifications;
+  CapturingTestLogger _log;
+  AlarmTableDefs* _alarm_table_defs;
+  pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+  MockAlarmScheduler* _alarm_scheduler;
+  AlarmReqListener* _alarm_req_listener;
+  AlarmManager* _alarm_manager;
+};
+
 // Check that setting/clearing alarms are translated into the correct
 // issuers/index/severity
 TEST_F(AlarmReqListenerTest, IssueAlarms)
@@ -152,6 +253,40 @@ TEST_F(AlarmReqListenerTest, SyncAlarms)
   sleep(1);
 }
 
+// Check that a batched ZMQ request to issue alarms is passed to the
+// scheduler as a single batch
+TEST_F(AlarmReqListenerTest, IssueAlarmsBatch)
+{
+  AlarmTriggers alarms;
+  alarms.push_back(std::make_pair("sprout", "1000.3"));
+  alarms.push_back(std::make_pair("homestead", "1001.1"));
+  EXPECT_CALL(*_alarm_scheduler, issue_alarms(alarms));
+
+  std::vector<std::string> req;
+  req.push_back("issue-alarms");
+  req.push_back("sprout");
+  req.push_back("1000.3");
+  req.push_back("homestead");
+  req.push_back("1001.1");
+  _alarm_manager->alarm_req_agent()->alarm_request(req);
+  sleep(1);
+}
+
+// Check that a batch with an issuer but no identifier is rejected
+TEST_F(AlarmReqListenerTest, IssueAlarmsBatchIncomplete)
+{
+  EXPECT_CALL(*_alarm_scheduler, issue_alarms(_)).Times(0);
+
+  std::vector<std::string> req;
+  req.push_back("issue-alarms");
+  req.push_back("sprout");
+  req.push_back("1000.3");
+  req.push_back("homestead");
+  _alarm_manager->alarm_req_agent()->alarm_request(req);
+  sleep(1);
+  EXPECT_TRUE(_log.contains("unexpected alarm request"));
+}
+
 TEST_F(AlarmReqListenerTest, InvalidZmqRequest)
 {
   std::vector<std::string> req;
@@ -262,10 +397,17 @@ TEST_F(AlarmReqListenerZmqErrorTest, Send)
     EXPECT_CALL(_mz, zmq_socket(_,_)).WillOnce(Return(&_s));
     EXPECT_CALL(_mz, zmq_setsockopt(_,_,_,_)).WillOnce(Return(0));
     EXPECT_CALL(_mz, zmq_bind(_,_)).WillOnce(Return(0));
+
+    // The client's identity and the empty delimiter frame.
+    EXPECT_CALL(_mz, zmq_msg_init(_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_msg_recv(_,_,_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_getsockopt(_,_,_,_)).WillOnce(Invoke(more_frames));
+    EXPECT_CALL(_mz, zmq_msg_close(_)).WillOnce(Return(0));
     EXPECT_CALL(_mz, zmq_msg_init(_)).WillOnce(Return(0));
     EXPECT_CALL(_mz, zmq_msg_recv(_,_,_)).WillOnce(Return(0));
-    EXPECT_CALL(_mz, zmq_getsockopt(_,_,_,_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_getsockopt(_,_,_,_)).WillOnce(Invoke(last_frame));
     EXPECT_CALL(_mz, zmq_msg_close(_)).WillOnce(Return(0));
+
     EXPECT_CALL(_mz, zmq_send(_,_,_,_)).WillOnce(Return(-1));
     EXPECT_CALL(_mz, zmq_msg_init(_)).WillOnce(Return(-1));
   }
@@ -283,6 +425,35 @@ TEST_F(AlarmReqListenerZmqErrorTest, Send)
   EXPECT_TRUE(_log.contains("zmq_msg_init failed:"));
 }
 
+// A message without a ROUTER envelope can't be replied to, so is dropped.
+TEST_F(AlarmReqListenerZmqErrorTest, NoEnvelope)
+{
+  {
+    InSequence s;
+    EXPECT_CALL(_mz, zmq_ctx_new()).WillOnce(Return(&_c));
+    EXPECT_CALL(_mz, zmq_socket(_,_)).WillOnce(Return(&_s));
+    EXPECT_CALL(_mz, zmq_setsockopt(_,_,_,_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_bind(_,_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_msg_init(_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_msg_recv(_,_,_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_getsockopt(_,_,_,_)).WillOnce(Invoke(last_frame));
+    EXPECT_CALL(_mz, zmq_msg_close(_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_msg_init(_)).WillOnce(Return(-1));
+  }
+
+  EXPECT_CALL(_mz, zmq_send(_,_,_,_)).Times(0);
+  EXPECT_CALL(_mz, zmq_close(_)).WillOnce(Return(0));
+  EXPECT_CALL(_mz, zmq_ctx_destroy(_)).WillOnce(Return(0));
+
+  EXPECT_TRUE(_alarm_req_listener->start(NULL));
+
+  _mz.call_complete(ZmqInterface::ZMQ_CLOSE, 5);
+
+  _alarm_req_listener->stop();
+
+  EXPECT_TRUE(_log.contains("alarm request has no envelope"));
+}
+
 TEST_F(AlarmReqListenerZmqErrorTest, CloseSocket)
 {
   EXPECT_CALL(_mz, zmq_ctx_new()).WillOnce(Return(&_c));
@@ -320,3 +491,151 @@ TEST_F(AlarmReqListenerZmqErrorTest, DestroyContext)
 
   EXPECT_TRUE(_log.contains("zmq_ctx_destroy failed:"));
 }
+
+// Requests beyond the queue limit are rejected rather than acknowledged.
+TEST_F(AlarmReqListenerZmqErrorTest, QueueFull)
+{
+  AlarmReqListener::Request request;
+  request.type = AlarmReqListener::Request::SYNC_ALARMS;
+
+  for (int ii = 0; ii < AlarmReqListener::MAX_QUEUED_REQUESTS; ii++)
+  {
+    EXPECT_TRUE(_alarm_req_listener->queue_request(request));
+  }
+  EXPECT_FALSE(_alarm_req_listener->queue_request(request));
+
+  EXPECT_CALL(_mz, zmq_send(_,_,_,_)).WillRepeatedly(Invoke(save_reply));
+  EXPECT_CALL(*_alarm_scheduler, sync_alarms()).Times(0);
+
+  std::vector<std::string> msg = {"client", "", "sync-alarms"};
+  _alarm_req_listener->handle_msg(msg);
+
+  EXPECT_EQ("busy", last_reply);
+  EXPECT_TRUE(_log.contains("Alarm request queue is full"));
+  EXPECT_EQ((size_t)AlarmReqListener::MAX_QUEUED_REQUESTS,
+            _alarm_req_listener->_queue.size());
+}
+
+// Check that a request that's ready is read and passed to the scheduler on
+// the calling thread.
+TEST_F(AlarmReqListenerInlineTest, HandleReadyRequests)
+{
+  EXPECT_FALSE(_alarm_req_listener->_worker_running);
+  EXPECT_NE(-1, _alarm_req_listener->get_fd());
+
+  bool synced = false;
+  EXPECT_CALL(*_alarm_scheduler, sync_alarms()).WillOnce(Assign(&synced, true));
+
+  std::vector<std::string> req;
+  req.push_back("sync-alarms");
+  _alarm_manager->alarm_req_agent()->alarm_request(req);
+
+  handle_requests_until(synced);
+  EXPECT_TRUE(synced);
+  EXPECT_TRUE(_alarm_req_listener->_queue.empty());
+}
+
+TEST_F(AlarmReqListenerZmqErrorTest, OpenCreateContext)
+{
+  EXPECT_CALL(_mz, zmq_ctx_new()).WillOnce(ReturnNull());
+
+  EXPECT_FALSE(_alarm_req_listener->open());
+  EXPECT_TRUE(_log.contains("zmq_ctx_new failed:"));
+}
+
+TEST_F(AlarmReqListenerZmqErrorTest, OpenCreateSocket)
+{
+  EXPECT_CALL(_mz, zmq_ctx_new()).WillOnce(Return(&_c));
+  EXPECT_CALL(_mz, zmq_socket(_,_)).WillOnce(ReturnNull());
+  EXPECT_CALL(_mz, zmq_ctx_destroy(_)).WillOnce(Return(0));
+
+  EXPECT_FALSE(_alarm_req_listener->open());
+  EXPECT_TRUE(_log.contains("zmq_socket failed:"));
+}
+
+// Check that open starts no threads, and that close tidies up the socket and
+// context.
+TEST_F(AlarmReqListenerZmqErrorTest, OpenAndClose)
+{
+  EXPECT_CALL(_mz, zmq_ctx_new()).WillOnce(Return(&_c));
+  EXPECT_CALL(_mz, zmq_socket(_,_)).WillOnce(Return(&_s));
+  EXPECT_CALL(_mz, zmq_setsockopt(_,_,_,_)).WillOnce(Return(0));
+  EXPECT_CALL(_mz, zmq_bind(_,_)).WillOnce(Return(0));
+  EXPECT_CALL(_mz, zmq_msg_init(_)).Times(0);
+
+  EXPECT_TRUE(_alarm_req_listener->open());
+  EXPECT_FALSE(_alarm_req_listener->_worker_running);
+
+  EXPECT_CALL(_mz, zmq_close(&_s)).WillOnce(Return(0));
+  EXPECT_CALL(_mz, zmq_ctx_destroy(&_c)).WillOnce(Return(0));
+  _alarm_req_listener->close();
+}
+
+TEST_F(AlarmReqListenerZmqErrorTest, GetFd)
+{
+  EXPECT_CALL(_mz, zmq_getsockopt(_, ZMQ_FD, _, _)).WillOnce(Return(-1));
+
+  EXPECT_EQ(-1, _alarm_req_listener->get_fd());
+  EXPECT_TRUE(_log.contains("zmq_getsockopt failed:"));
+}
+
+// Check that nothing is read unless ZMQ says the socket is readable.
+TEST_F(AlarmReqListenerZmqErrorTest, HandleReadyRequestsNotReadable)
+{
+  {
+    InSequence s;
+    EXPECT_CALL(_mz, zmq_getsockopt(_, ZMQ_EVENTS, _, _)).WillOnce(Invoke(not_readable));
+    EXPECT_CALL(_mz, zmq_getsockopt(_, ZMQ_EVENTS, _, _)).WillOnce(Return(-1));
+  }
+  EXPECT_CALL(_mz, zmq_msg_init(_)).Times(0);
+
+  _alarm_req_listener->handle_ready_requests();
+  _alarm_req_listener->handle_ready_requests();
+}
+
+// Check that requests are read without blocking, and that there being nothing
+// to read after all isn't an error.
+TEST_F(AlarmReqListenerZmqErrorTest, HandleReadyRequestsWouldBlock)
+{
+  {
+    InSequence s;
+    EXPECT_CALL(_mz, zmq_getsockopt(_, ZMQ_EVENTS, _, _)).WillOnce(Invoke(readable));
+    EXPECT_CALL(_mz, zmq_msg_init(_)).WillOnce(Return(0));
+    EXPECT_CALL(_mz, zmq_msg_recv(_, _, ZMQ_DONTWAIT)).WillOnce(Invoke(would_block));
+  }
+  EXPECT_CALL(*_alarm_scheduler, sync_alarms()).Times(0);
+
+  _alarm_req_listener->handle_ready_requests();
+
+  EXPECT_FALSE(_log.contains("zmq_msg_recv failed:"));
+}
+
+// Check that when there's no worker thread, requests are passed straight to
+// the scheduler rather than queued, and are acknowledged afterwards.
+TEST_F(AlarmReqListenerZmqErrorTest, InlineRequests)
+{
+  _alarm_req_listener->_inline_requests = true;
+
+  {
+    InSequence s;
+    EXPECT_CALL(*_alarm_scheduler, issue_alarm("sprout", "1000.3"));
+    EXPECT_CALL(_mz, zmq_send(_,_,_,_)).Times(3).WillRepeatedly(Invoke(save_reply));
+  }
+
+  std::vector<std::string> msg = {"client", "", "issue-alarm", "sprout", "1000.3"};
+  _alarm_req_listener->handle_msg(msg);
+
+  EXPECT_EQ("ok", last_reply);
+  EXPECT_TRUE(_alarm_req_listener->_queue.empty());
+
+  // Requests aren't limited by the queue length.
+  AlarmReqListener::Request request;
+  request.type = AlarmReqListener::Request::SYNC_ALARMS;
+  EXPECT_CALL(*_alarm_scheduler, sync_alarms()).Times(AlarmReqListener::MAX_QUEUED_REQUESTS + 1);
+
+  for (int ii = 0; ii <= AlarmReqListener::MAX_QUEUED_REQUESTS; ii++)
+  {
+    EXPECT_TRUE(_alarm_req_listener->queue_request(request));
+  }
+  EXPECT_TRUE(_alarm_req_listener->_queue.empty());
+}
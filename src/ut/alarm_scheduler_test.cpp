@@ -198,6 +198,12 @@ public:
     _callbacks.emplace_back(callback, correlator);
   }
 
+  int collect_async_callback(netsnmp_session* ignored_session, netsnmp_pdu* ignored_pdu, snmp_callback callback, void* correlator)
+  {
+    _callbacks.emplace_back(callback, correlator);
+    return 1;
+  }
+
 private:
   std::vector<std::pair<snmp_callback, void*>> _callbacks;
 };
@@ -235,6 +241,8 @@ private:
 // Safely set up an expect call for an SNMP trap send that will succeed.
 #define COLLECT_CALL(CALL) EXPECT_CALL(_ms, CALL).                                \
   WillOnce(Invoke(&_collector, &SNMPCallbackCollector::collect_callback))
+#define COLLECT_ASYNC_CALL(CALL) EXPECT_CALL(_ms, CALL).                          \
+  WillOnce(Invoke(&_collector, &SNMPCallbackCollector::collect_async_callback))
 #define COLLECT_CALLS(N, CALL) EXPECT_CALL(_ms, CALL).                            \
   Times(N).                                                                       \
   WillRepeatedly(Invoke(&_collector, &SNMPCallbackCollector::collect_callback))
@@ -281,6 +289,38 @@ TEST_F(AlarmSchedulerTest, SetRFCAlarm)
   _ms.trap_complete(1, 5);
 }
 
+// Test that the trap sender can still send an alarm whose definition it
+// didn't build a template for
+TEST_F(AlarmSchedulerTest, SendAlarmWithoutTemplate)
+{
+  std::set<NotificationType> snmp_notifications;
+  snmp_notifications.insert(NotificationType::RFC3877);
+  _alarm_scheduler = new AlarmScheduler(_alarm_table_defs, snmp_notifications, "hostname1", _lock);
+
+  AlarmTableDef alarm_table_def = _alarm_table_defs->get_definition(1000, 3);
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE, 1000), _, _));
+  AlarmTrapSender::get_instance().send_trap(alarm_table_def);
+  _collector.call_all_callbacks();
+}
+
+// Test that when the scheduler is driven from an event loop, an alarm is due
+// as soon as it's raised, but is only sent when the loop asks for it
+TEST_F(AlarmSchedulerTest, EventLoopSendsDueAlarms)
+{
+  std::set<NotificationType> snmp_notifications;
+  snmp_notifications.insert(NotificationType::RFC3877);
+  _alarm_scheduler = new AlarmScheduler(_alarm_table_defs, snmp_notifications, "hostname1", _lock, false);
+  EXPECT_EQ(UINT64_MAX, _alarm_scheduler->get_next_check_time());
+
+  _alarm_scheduler->issue_alarm("test", "1000.3");
+  EXPECT_LE(_alarm_scheduler->get_next_check_time(), Utils::get_time());
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE, 1000), _, _));
+  _alarm_scheduler->send_due_alarms();
+  EXPECT_EQ(UINT64_MAX, _alarm_scheduler->get_next_check_time());
+}
+
 // Simple test that raising an Enterprise MIB style alarm triggers an INFORM to
 // be sent immediately
 TEST_F(AlarmSchedulerTest, SetEnterpriseAlarm)
@@ -362,7 +402,7 @@ TEST_F(AlarmSchedulerTest, SetAndClearAlarm)
   _alarm_scheduler->issue_alarm("test", "1000.3");
   _ms.trap_complete(1, 5);
 
-  // Now clear the alarm. Block until we're waiting for the heap (note - this
+  // Now clear the alarm. Block until we're waiting for the wheel (note - this
   // doesn't prove we're waiting on the alarm to be due, but the next check
   // will fail if we aren't).
   _alarm_scheduler->issue_alarm("test", "1000.1");
@@ -372,9 +412,9 @@ TEST_F(AlarmSchedulerTest, SetAndClearAlarm)
   // cleared alarm is sent.
   cwtest_advance_time_ms(AlarmScheduler::ALARM_REDUCED_DELAY);
   COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::CLEAR, 1000), _, _));
-  pthread_mutex_lock(&_lock);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
   _alarm_scheduler->_cond->signal();
-  pthread_mutex_unlock(&_lock);
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
   _ms.trap_complete(1, 5);
 }
 
@@ -450,6 +490,79 @@ TEST_F(AlarmSchedulerTest, SyncAlarms)
   _ms.trap_complete(3, 5);
 }
 
+// Test that a rate limited resync sends the most severe alarms first, and
+// paces the rest
+TEST_F(AlarmSchedulerTest, SyncAlarmsRateLimited)
+{
+  std::set<NotificationType> snmp_notifications;
+  snmp_notifications.insert(NotificationType::RFC3877);
+  _alarm_scheduler = new AlarmScheduler(_alarm_table_defs, snmp_notifications, "hostname1", _lock);
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::CLEAR,
+                                        1001), _, _));
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE,
+                                        2000), _, _));
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE,
+                                        1000), _, _));
+
+  _alarm_scheduler->issue_alarm("test", "1001.1");
+  _alarm_scheduler->issue_alarm("test", "2000.4");
+  _alarm_scheduler->issue_alarm("test", "1000.3");
+
+  _ms.trap_complete(3, 5);
+
+  // Allow one alarm a second. The critical alarm is resent straight away,
+  // then the major alarm, and finally the clear.
+  _alarm_scheduler->set_resync_rate(1, 1);
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE,
+                                        1000), _, _));
+  _alarm_scheduler->sync_alarms();
+  _ms.trap_complete(1, 5);
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE,
+                                        2000), _, _));
+  cwtest_advance_time_ms(1000);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
+  _alarm_scheduler->_cond->signal();
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
+  _ms.trap_complete(1, 5);
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::CLEAR,
+                                        1001), _, _));
+  cwtest_advance_time_ms(1000);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
+  _alarm_scheduler->_cond->signal();
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
+  _ms.trap_complete(1, 5);
+}
+
+// Test that a batch of alarms generates INFORMs for each valid alarm in the
+// batch, skipping any it doesn't recognise
+TEST_F(AlarmSchedulerTest, IssueAlarmsBatch)
+{
+  std::set<NotificationType> snmp_notifications;
+  snmp_notifications.insert(NotificationType::RFC3877);
+  _alarm_scheduler = new AlarmScheduler(_alarm_table_defs, snmp_notifications, "hostname1", _lock);
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE,
+                                        1000), _, _));
+
+  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::CLEAR,
+                                        1001), _, _));
+
+  AlarmTriggers alarms;
+  alarms.push_back(std::make_pair("test", "1000.3"));
+  alarms.push_back(std::make_pair("test", "6000.3"));
+  alarms.push_back(std::make_pair("test", "1001.1"));
+  _alarm_scheduler->issue_alarms(alarms);
+
+  _ms.trap_complete(2, 5);
+  EXPECT_TRUE(_log.contains("Unknown alarm definition"));
+}
+
 // Test that an alarm flicker situation doesn't cause flickering INFORMs
 // (by sending multiple set/clears, and checking that this doesn't
 // generate informs).
@@ -473,13 +586,14 @@ TEST_F(AlarmSchedulerTest, AlarmFlicker)
   }
 
   cwtest_advance_time_ms(AlarmScheduler::ALARM_REDUCED_DELAY);
-  pthread_mutex_lock(&_lock);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
   _alarm_scheduler->_cond->signal();
-  pthread_mutex_unlock(&_lock);
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
   _ms.trap_complete(1, 5);
 }
 
-// Test that a failed alarm is retried after a delay
+// Test that a failed alarm is retried after a delay, to just the sink that
+// didn't respond, and keeps being retried if it can't be sent
 TEST_F(AlarmSchedulerTest, AlarmFailedToSend)
 {
   std::set<NotificationType> snmp_notifications;
@@ -499,18 +613,62 @@ TEST_F(AlarmSchedulerTest, AlarmFailedToSend)
   snmp_session session;
   session.peername = strdup("peer");
   callback(NETSNMP_CALLBACK_OP_TIMED_OUT, &session, 2, NULL, correlator);
-  free(session.peername);
   pthread_mutex_unlock(&_lock);
 
   // Now advance time by the retry delay amount. This triggers the retry to be
-  // sent
-  COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::ACTIVE,
-                                       1000), _, _));
+  // sent to the sink, which fails, so it's scheduled again.
+  EXPECT_CALL(_ms, snmp_async_send(&session, _, _, _)).WillOnce(Return(0));
   cwtest_advance_time_ms(AlarmScheduler::ALARM_RETRY_DELAY);
-  pthread_mutex_lock(&_lock);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
   _alarm_scheduler->_cond->signal();
-  pthread_mutex_unlock(&_lock);
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
   _ms.trap_complete(1, 5);
+
+  COLLECT_ASYNC_CALL(snmp_async_send(&session, _, _, _));
+  cwtest_advance_time_ms(AlarmScheduler::ALARM_RETRY_DELAY);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
+  _alarm_scheduler->_cond->signal();
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
+  _ms.trap_complete(1, 5);
+
+  free(session.peername);
+}
+
+// Test that when several sinks don't respond to an alarm, it's retried to
+// each of them at once
+TEST_F(AlarmSchedulerTest, AlarmFailedToSendToTwoSinks)
+{
+  std::set<NotificationType> snmp_notifications;
+  snmp_notifications.insert(NotificationType::RFC3877);
+  _alarm_scheduler = new AlarmScheduler(_alarm_table_defs, snmp_notifications, "hostname1", _lock);
+
+  snmp_callback callback;
+  void* correlator;
+  EXPECT_CALL(_ms, send_v2trap(_, _, _)).
+    WillOnce(DoAll(SaveArg<1>(&callback),
+                   SaveArg<2>(&correlator)));
+  _alarm_scheduler->issue_alarm("test", "1000.3");
+  _ms.trap_complete(1, 5);
+
+  pthread_mutex_lock(&_lock);
+  snmp_session session1;
+  session1.peername = strdup("peer1");
+  snmp_session session2;
+  session2.peername = strdup("peer2");
+  callback(NETSNMP_CALLBACK_OP_TIMED_OUT, &session1, 2, NULL, correlator);
+  callback(NETSNMP_CALLBACK_OP_TIMED_OUT, &session2, 3, NULL, correlator);
+  pthread_mutex_unlock(&_lock);
+
+  COLLECT_ASYNC_CALL(snmp_async_send(&session1, _, _, _));
+  COLLECT_ASYNC_CALL(snmp_async_send(&session2, _, _, _));
+  cwtest_advance_time_ms(AlarmScheduler::ALARM_RETRY_DELAY);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
+  _alarm_scheduler->_cond->signal();
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
+  _ms.trap_complete(2, 5);
+
+  free(session1.peername);
+  free(session2.peername);
 }
 
 // Test that when the raise alarm fails, but a clear alarm has been sent in later,
@@ -541,9 +699,9 @@ TEST_F(AlarmSchedulerTest, AlarmFailedToSendClearedInInterval)
   COLLECT_CALL(send_v2trap(RFCTrapVars(RFCTrapVarsMatcher::CLEAR,
                                        1000), _, _));
   cwtest_advance_time_ms(AlarmScheduler::ALARM_REDUCED_DELAY);
-  pthread_mutex_lock(&_lock);
+  pthread_mutex_lock(&_alarm_scheduler->_lock);
   _alarm_scheduler->_cond->signal();
-  pthread_mutex_unlock(&_lock);
+  pthread_mutex_unlock(&_alarm_scheduler->_lock);
   _ms.trap_complete(1, 5);
 }
 
@@ -92,3 +92,87 @@ TEST_F(AlarmTableDefsTest, InvalidTableDefLookup)
 
   EXPECT_FALSE(_def.is_valid());
 }
+
+TEST_F(AlarmTableDefsTest, TableDefLookupAllSeverities)
+{
+  EXPECT_TRUE(_defs.initialize(std::string(UT_DIR).append("/valid_alarms/")));
+
+  // Alarm 2000 is defined with CLEARED, MAJOR and MINOR severities only.
+  for (unsigned int severity = AlarmDef::UNDEFINED_SEVERITY;
+       severity <= AlarmDef::WARNING;
+       severity++)
+  {
+    AlarmTableDef& def = _defs.get_definition(2000, severity);
+    bool defined = ((severity == AlarmDef::CLEARED) ||
+                    (severity == AlarmDef::MAJOR) ||
+                    (severity == AlarmDef::MINOR));
+
+    EXPECT_EQ(defined, def.is_valid());
+
+    if (defined)
+    {
+      EXPECT_EQ(2000u, def.alarm_index());
+      EXPECT_EQ(severity, (unsigned int)def.severity());
+    }
+  }
+
+  // Indexes between and outside the defined alarms, and unknown severities,
+  // aren't found.
+  EXPECT_FALSE(_defs.get_definition(1500, AlarmDef::CLEARED).is_valid());
+  EXPECT_FALSE(_defs.get_definition(999, AlarmDef::CLEARED).is_valid());
+  EXPECT_FALSE(_defs.get_definition(2001, AlarmDef::CLEARED).is_valid());
+  EXPECT_FALSE(_defs.get_definition(1000, AlarmDef::WARNING + 1).is_valid());
+}
+
+// Each distinct string is stored once, however many definitions use it.
+TEST_F(AlarmTableDefsTest, SharedStrings)
+{
+  EXPECT_TRUE(_defs.initialize(std::string(UT_DIR).append("/valid_alarms/")));
+
+  AlarmTableDef& cleared = _defs.get_definition(1000, AlarmDef::CLEARED);
+  AlarmTableDef& critical = _defs.get_definition(1000, AlarmDef::CRITICAL);
+
+  EXPECT_TRUE(cleared.is_valid());
+  EXPECT_TRUE(critical.is_valid());
+  EXPECT_EQ(&cleared.name(), &critical.name());
+}
+
+// A copy of the definitions has its own strings, so outlives the original.
+TEST_F(AlarmTableDefsTest, CopyDefinitions)
+{
+  AlarmTableDefs* defs = new AlarmTableDefs();
+  EXPECT_TRUE(defs->initialize(std::string(UT_DIR).append("/valid_alarms/")));
+  AlarmTableDefs copy(*defs);
+  delete defs; defs = NULL;
+
+  AlarmTableDef& def = copy.get_definition(1000, AlarmDef::CRITICAL);
+  EXPECT_TRUE(def.is_valid());
+  EXPECT_THAT(def.name(), StrEq("PROCESS_FAIL"));
+  EXPECT_THAT(def.description(), StrEq("Process failure"));
+}
+
+// Definitions built directly take their strings from the given details.
+TEST_F(AlarmTableDefsTest, MakeDefinition)
+{
+  AlarmDef::SeverityDetails raised(AlarmDef::MAJOR,
+                                   "Raised description",
+                                   "Raised details",
+                                   "Raised cause",
+                                   "Raised effect",
+                                   "Raised action",
+                                   "Raised extended details",
+                                   "Raised extended description");
+  AlarmDef::AlarmDefinition alarm("TEST_ALARM", 3000, AlarmDef::SOFTWARE_ERROR, {raised});
+
+  AlarmTableDef def = _defs.make_definition(alarm, raised);
+
+  EXPECT_TRUE(def.is_valid());
+  EXPECT_EQ(3000u, def.alarm_index());
+  EXPECT_EQ(AlarmDef::MAJOR, def.severity());
+  EXPECT_THAT(def.name(), StrEq("TEST_ALARM"));
+  EXPECT_THAT(def.description(), StrEq("Raised description"));
+  EXPECT_THAT(def.extended_description(), StrEq("Raised extended description"));
+
+  // It isn't added to the definitions.
+  EXPECT_FALSE(_defs.get_definition(3000, AlarmDef::MAJOR).is_valid());
+}
@@ -23,6 +23,9 @@ public:
   AlarmTableDef* def_raised_critical;
   AlarmTableDef* def_raised_major;
 
+  // Holds the strings of the definitions above.
+  AlarmTableDefs defs;
+
   static void SetUpTestCase();
 
   void SetUp();
@@ -56,8 +59,8 @@ void CustomDefs::SetUp()
                                    "Test alarm raised extended details",
                                    "Test alarm raised extended description");
   AlarmDef::AlarmDefinition example("test alarm", 6666, AlarmDef::SOFTWARE_ERROR, {cleared, raised});
-  def_cleared = new AlarmTableDef(example, cleared);
-  def_raised = new AlarmTableDef(example, raised);
+  def_cleared = new AlarmTableDef(defs.make_definition(example, cleared));
+  def_raised = new AlarmTableDef(defs.make_definition(example, raised));
 
   AlarmDef::SeverityDetails cleared1(AlarmDef::CLEARED,
                                      "First alarm cleared description",
@@ -76,8 +79,8 @@ void CustomDefs::SetUp()
                                     "First alarm raised extended details",
                                     "First alarm raised extended description");
   AlarmDef::AlarmDefinition example1("test alarm1", 6666, AlarmDef::SOFTWARE_ERROR, {cleared1, raised1});
-  def1_cleared = new AlarmTableDef(example1, cleared1);
-  def1_raised = new AlarmTableDef(example1, raised1);
+  def1_cleared = new AlarmTableDef(defs.make_definition(example1, cleared1));
+  def1_raised = new AlarmTableDef(defs.make_definition(example1, raised1));
 
   AlarmDef::SeverityDetails cleared2(AlarmDef::CLEARED,
                                      "Second alarm cleared description",
@@ -96,8 +99,8 @@ void CustomDefs::SetUp()
                                     "Second alarm raised extended details",
                                     "Second alarm raised extended description");
   AlarmDef::AlarmDefinition example2("test alarm2", 6667, AlarmDef::SOFTWARE_ERROR, {cleared2, raised2});
-  def2_cleared = new AlarmTableDef(example2, cleared2);
-  def2_raised = new AlarmTableDef(example2, raised2);
+  def2_cleared = new AlarmTableDef(defs.make_definition(example2, cleared2));
+  def2_raised = new AlarmTableDef(defs.make_definition(example2, raised2));
 
   AlarmDef::SeverityDetails cleared3(AlarmDef::CLEARED,
                                      "Third alarm cleared description",
@@ -116,8 +119,8 @@ void CustomDefs::SetUp()
                                     "Third alarm raised extended details",
                                     "Third alarm raised extended description");
   AlarmDef::AlarmDefinition example3("test alarm3", 6668, AlarmDef::SOFTWARE_ERROR, {cleared3, raised3});
-  def3_cleared = new AlarmTableDef(example3, cleared3);
-  def3_raised = new AlarmTableDef(example3, raised3);
+  def3_cleared = new AlarmTableDef(defs.make_definition(example3, cleared3));
+  def3_raised = new AlarmTableDef(defs.make_definition(example3, raised3));
 
   AlarmDef::SeverityDetails cleared4(AlarmDef::CLEARED,
                                      "Fourth alarm cleared description",
@@ -136,8 +139,8 @@ void CustomDefs::SetUp()
                                     "Fourth alarm raised extended details",
                                     "Fourth alarm raised extended description");
   AlarmDef::AlarmDefinition example4("test alarm4", 6669, AlarmDef::SOFTWARE_ERROR, {cleared4, raised4});
-  def4_cleared = new AlarmTableDef(example4, cleared4);
-  def4_raised = new AlarmTableDef(example4, raised4);
+  def4_cleared = new AlarmTableDef(defs.make_definition(example4, cleared4));
+  def4_raised = new AlarmTableDef(defs.make_definition(example4, raised4));
 
   AlarmDef::SeverityDetails cleared5(AlarmDef::CLEARED,
                                      "Fifth alarm cleared description",
@@ -156,8 +159,8 @@ void CustomDefs::SetUp()
                                     "Fifth alarm raised extended details",
                                     "Fifth alarm raised extended description");
   AlarmDef::AlarmDefinition example5("test alarm5", 6670, AlarmDef::SOFTWARE_ERROR, {cleared5, raised5});
-  def5_cleared = new AlarmTableDef(example5, cleared5);
-  def5_raised = new AlarmTableDef(example5, raised5);
+  def5_cleared = new AlarmTableDef(defs.make_definition(example5, cleared5));
+  def5_raised = new AlarmTableDef(defs.make_definition(example5, raised5));
 
   AlarmDef::SeverityDetails cleared6(AlarmDef::CLEARED,
                                      "Test alarm cleared description",
@@ -184,9 +187,9 @@ void CustomDefs::SetUp()
                                          "Test alarm major raised extended details",
                                          "Test alarm major raised extended description");
   AlarmDef::AlarmDefinition example6("test alarm6", 6666, AlarmDef::SOFTWARE_ERROR, {cleared, raised_critical, raised_major});
-  def6_cleared = new AlarmTableDef(example6, cleared6);
-  def_raised_critical = new AlarmTableDef(example, raised_critical);
-  def_raised_major = new AlarmTableDef(example, raised_major);
+  def6_cleared = new AlarmTableDef(defs.make_definition(example6, cleared6));
+  def_raised_critical = new AlarmTableDef(defs.make_definition(example, raised_critical));
+  def_raised_major = new AlarmTableDef(defs.make_definition(example, raised_major));
 }
 
 void CustomDefs::TearDown()
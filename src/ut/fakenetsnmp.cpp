@@ -126,6 +126,26 @@ void send_v2trap(netsnmp_variable_list *variable_list, snmp_callback callback, v
   }
 }
 
+int snmp_async_send(netsnmp_session *session, netsnmp_pdu *pdu, snmp_callback callback, void* correlator)
+{
+  int rc = 0;
+
+  if (netsnmp_intf_p)
+  {
+    rc = netsnmp_intf_p->snmp_async_send(session, pdu, callback, correlator);
+
+    netsnmp_intf_p->trap_signal();
+  }
+
+  // Net-SNMP takes ownership of the PDU if it's sent.
+  if (rc != 0)
+  {
+    snmp_free_pdu(pdu);
+  }
+
+  return rc;
+}
+
 int snmp_log(int priority, const char *format, ...)
 {
   if (netsnmp_intf_p)
@@ -25,6 +25,7 @@ public:
   NetSnmpInterface();
 
   virtual void send_v2trap(netsnmp_variable_list *, snmp_callback, void*) = 0;
+  virtual int snmp_async_send(netsnmp_session*, netsnmp_pdu*, snmp_callback, void*) = 0;
 
   bool trap_complete(int count, int timeout);
   void trap_signal();
@@ -45,6 +46,7 @@ class MockNetSnmpInterface : public NetSnmpInterface
 {
 public:
   MOCK_METHOD3(send_v2trap, void(netsnmp_variable_list *, snmp_callback, void*));
+  MOCK_METHOD4(snmp_async_send, int(netsnmp_session*, netsnmp_pdu*, snmp_callback, void*));
 };
 
 void cwtest_intercept_netsnmp(NetSnmpInterface* intf);
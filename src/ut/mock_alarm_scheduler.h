@@ -26,6 +26,7 @@ public:
 
   MOCK_METHOD2(issue_alarm, void(const std::string& issuer,
                                  const std::string& identifier));
+  MOCK_METHOD1(issue_alarms, void(const AlarmTriggers& alarms));
   MOCK_METHOD0(sync_alarms, void());
 };
 
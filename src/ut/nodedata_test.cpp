@@ -0,0 +1,181 @@
+/**
+ * @file nodedata_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include <ctime>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "nodedata.hpp"
+#include "astaire_handlers.hpp"
+
+// Astaire's two handlers share the astaire root OID, so walks through its
+// stats have to work out which handlers' subtrees they pass through.
+class AstaireNodeDataTest : public ::testing::Test
+{
+public:
+  AstaireNodeDataTest() :
+    _root("1.2.826.0.1.1578918.9.9"),
+    _global_handler(_root, &_tree),
+    _connections_handler(_root, &_tree),
+    _node_data("astaire",
+               _root,
+               {"astaire_global", "astaire_connections"},
+               {{"astaire_global", &_global_handler},
+                {"astaire_connections", &_connections_handler}},
+               NodeData::DEFAULT_IDLE_UNSUBSCRIBE_TIME,
+               true),
+    _now(time(NULL))
+  {
+    // Store a publish for each stat, as the listener does for lazily parsed
+    // stats.
+    std::vector<std::string> global = {"astaire_global", "OK",
+                                       "1", "2", "3", "4", "5"};
+    _global_handler.store_pending(global);
+    _global_handler.update_last_seen_time(_now);
+
+    // One connection, with one bucket.
+    std::vector<std::string> connections = {"astaire_connections", "OK",
+                                            "10.0.0.1", "11211", "6", "7", "1",
+                                            "8", "9", "10", "11"};
+    _connections_handler.store_pending(connections);
+    _connections_handler.update_last_seen_time(_now);
+  }
+
+  // Checks that the given OID is in the given table of the astaire MIB.
+  void expect_in_table(const OID& oid, int table)
+  {
+    EXPECT_TRUE(OID(_root, table).subtree_contains(oid)) << oid.to_string();
+  }
+
+  OID _root;
+  OIDTree _tree;
+  AstaireGlobalStatHandler _global_handler;
+  AstaireConnectionStatHandler _connections_handler;
+  NodeData _node_data;
+  long _now;
+};
+
+// Tests that each handler owns only its own tables under the shared root.
+TEST_F(AstaireNodeDataTest, Ownership)
+{
+  EXPECT_FALSE(_global_handler.owns(_root));
+  EXPECT_FALSE(_connections_handler.owns(_root));
+
+  EXPECT_TRUE(_global_handler.owns(OID(_root, "1.0")));
+  EXPECT_TRUE(_global_handler.owns(OID(_root, "5.1.2.1")));
+  EXPECT_TRUE(_global_handler.owns(OID(_root, "9.0")));
+  EXPECT_FALSE(_global_handler.owns(OID(_root, "6.1.4")));
+
+  EXPECT_TRUE(_connections_handler.owns(OID(_root, "6.1.4")));
+  EXPECT_TRUE(_connections_handler.owns(OID(_root, "8.1.6")));
+  EXPECT_FALSE(_connections_handler.owns(OID(_root, "9.0")));
+
+  // The connection tables lie between the global stats.
+  OID bandwidth(_root, "5.1.2.1");
+  OID data64(_root, "9.0");
+  EXPECT_TRUE(_connections_handler.owns_after(bandwidth, &data64));
+  EXPECT_TRUE(_global_handler.owns_after(bandwidth, &data64));
+  EXPECT_FALSE(_connections_handler.owns_after(data64, NULL));
+  EXPECT_FALSE(_connections_handler.owns_after(_root, &bandwidth));
+}
+
+// Tests that a walk from the astaire root parses the stored publishes and
+// returns the first entry.
+TEST_F(AstaireNodeDataTest, WalkFromRoot)
+{
+  OID next_oid;
+  StatValue value;
+  ZMQMessageHandler* handler = NULL;
+
+  ASSERT_TRUE(_node_data.get_next(_tree, _root, _now, next_oid, value, handler));
+  EXPECT_TRUE(OID(_root, "1.0").equals(next_oid)) << next_oid.to_string();
+  EXPECT_EQ(1u, value);
+  EXPECT_EQ(&_global_handler, handler);
+  EXPECT_FALSE(_global_handler.has_pending());
+}
+
+// Tests that a walk from the global stats into the connection tables parses
+// the stored connections publish, even though the global stats that follow
+// the connection tables are already in the tree.
+TEST_F(AstaireNodeDataTest, WalkFromGlobalIntoConnections)
+{
+  _global_handler.materialize();
+  EXPECT_TRUE(_connections_handler.has_pending());
+
+  OID next_oid;
+  StatValue value;
+  ZMQMessageHandler* handler = NULL;
+
+  ASSERT_TRUE(_node_data.get_next(_tree,
+                                  OID(_root, "5.1.2.1"),
+                                  _now,
+                                  next_oid,
+                                  value,
+                                  handler));
+  expect_in_table(next_oid, 6);
+  EXPECT_EQ(6u, value);
+  EXPECT_EQ(&_connections_handler, handler);
+  EXPECT_FALSE(_connections_handler.has_pending());
+
+  // Walk on through the rest of the connection tables to the 64-bit data
+  // count.
+  int entries = 0;
+  while (_connections_handler.owns(next_oid))
+  {
+    entries++;
+    ASSERT_TRUE(_node_data.get_next(_tree, next_oid, _now, next_oid, value, handler));
+  }
+  EXPECT_EQ(6, entries);
+  EXPECT_TRUE(OID(_root, "9.0").equals(next_oid)) << next_oid.to_string();
+  EXPECT_EQ(4u, value);
+}
+
+// Tests that a walk only parses the stored publishes of stats it passes
+// through.
+TEST_F(AstaireNodeDataTest, WalkPastConnections)
+{
+  OID next_oid;
+  StatValue value;
+  ZMQMessageHandler* handler = NULL;
+
+  ASSERT_TRUE(_node_data.get_next(_tree,
+                                  OID(_root, 9),
+                                  _now,
+                                  next_oid,
+                                  value,
+                                  handler));
+  EXPECT_TRUE(OID(_root, "9.0").equals(next_oid)) << next_oid.to_string();
+  EXPECT_EQ(&_global_handler, handler);
+  EXPECT_TRUE(_connections_handler.has_pending());
+
+  EXPECT_FALSE(_node_data.get_next(_tree, next_oid, _now, next_oid, value, handler));
+  EXPECT_TRUE(_connections_handler.has_pending());
+}
+
+// Tests that a walk skips the entries of stats that have gone stale.
+TEST_F(AstaireNodeDataTest, WalkPastStaleStats)
+{
+  _connections_handler.update_last_seen_time(_now - 60);
+
+  OID next_oid;
+  StatValue value;
+  ZMQMessageHandler* handler = NULL;
+
+  ASSERT_TRUE(_node_data.get_next(_tree,
+                                  OID(_root, "5.1.2.1"),
+                                  _now,
+                                  next_oid,
+                                  value,
+                                  handler));
+  EXPECT_TRUE(OID(_root, "9.0").equals(next_oid)) << next_oid.to_string();
+  EXPECT_EQ(&_global_handler, handler);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file oid_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "oid.hpp"
+
+// Tests each way of building an OID.
+TEST(OIDTest, Constructors)
+{
+  const oid elements[] = {4, 5, 6};
+  OID parent("1.2.3");
+
+  EXPECT_EQ("", OID().to_string());
+  EXPECT_EQ(".7", OID(7).to_string());
+  EXPECT_EQ(".1.2.3.7", OID(parent, 7).to_string());
+  EXPECT_EQ(".4.5.6", OID(elements, 3).to_string());
+  EXPECT_EQ(".1.2.3.4.5.6", OID(parent, elements, 3).to_string());
+  EXPECT_EQ(".1.2.3", OID(".1.2.3").to_string());
+  EXPECT_EQ(".1.2.3.4.5", OID(parent, "4.5").to_string());
+  EXPECT_EQ(".1.4.127.0.0.1", OID(OIDInetAddr("127.0.0.1")).to_string());
+  EXPECT_EQ(".1.2.3.1.4.10.0.0.1",
+            OID(parent, OIDInetAddr("10.0.0.1")).to_string());
+}
+
+// Tests that IPv6 addresses are encoded as an RFC 4001 InetAddress, and
+// anything that isn't an address isn't encoded at all.
+TEST(OIDTest, InetAddr)
+{
+  EXPECT_EQ(".2.16.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.1",
+            OID(OIDInetAddr("::1")).to_string());
+
+  OIDInetAddr invalid("not.an.address");
+  EXPECT_FALSE(invalid.isValid());
+  EXPECT_EQ(".1.2.3", OID(OID("1.2.3"), invalid).to_string());
+
+  EXPECT_FALSE(OIDInetAddr().isValid());
+}
+
+// Tests comparing OIDs.
+TEST(OIDTest, Compare)
+{
+  OID oid("1.2.3");
+  EXPECT_TRUE(oid.equals(OID("1.2.3")));
+  EXPECT_FALSE(oid.equals(OID("1.2.3.4")));
+  EXPECT_FALSE(oid.equals(OID("1.2.4")));
+
+  EXPECT_TRUE(oid.subtree_contains(OID("1.2.3")));
+  EXPECT_TRUE(oid.subtree_contains(OID("1.2.3.4.5")));
+  EXPECT_FALSE(oid.subtree_contains(OID("1.2.4.5")));
+
+  // Only the common prefix is compared, so OIDs above the subtree root match
+  // too.
+  EXPECT_TRUE(oid.subtree_contains(OID("1.2")));
+}
+
+// Tests that truncating an OID keeps only its first elements, and does
+// nothing if it's already short enough.
+TEST(OIDTest, Truncate)
+{
+  OID oid("1.2.3.4");
+  oid.truncate(2);
+  EXPECT_EQ(".1.2", oid.to_string());
+
+  oid.truncate(3);
+  EXPECT_EQ(".1.2", oid.to_string());
+
+  oid.append("5.6");
+  EXPECT_EQ(".1.2.5.6", oid.to_string());
+  EXPECT_EQ(4, oid.get_len());
+}
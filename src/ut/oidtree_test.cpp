@@ -0,0 +1,118 @@
+/**
+ * @file oidtree_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "oidtree.hpp"
+
+class OIDTreeTest : public ::testing::Test
+{
+public:
+  // The roots of two components, each with its own shard.
+  OIDTreeTest() :
+    _sprout("1.2.826.0.1.1578918.9.3"),
+    _memento("1.2.826.0.1.1578918.9.8")
+  {}
+
+  // Returns the OIDs in the tree, in order.
+  std::vector<std::string> walk()
+  {
+    std::vector<std::string> oids;
+    OID oid("1");
+    StatValue value;
+    while (_tree.get_next(oid, oid, value))
+    {
+      oids.push_back(oid.to_string());
+    }
+    return oids;
+  }
+
+  OID _sprout;
+  OID _memento;
+  OIDTree _tree;
+};
+
+// Tests getting, setting and removing single entries.
+TEST_F(OIDTreeTest, SetAndRemove)
+{
+  StatValue value;
+  EXPECT_FALSE(_tree.get(OID(_sprout, "1.0"), value));
+
+  _tree.set(OID(_sprout, "1.0"), 1);
+  _tree.set(OID(_memento, "1.0"), 2);
+  EXPECT_TRUE(_tree.get(OID(_sprout, "1.0"), value));
+  EXPECT_EQ(1u, value);
+  EXPECT_FALSE(_tree.get(OID(_sprout, "2.0"), value));
+
+  _tree.remove(OID(_sprout, "1.0"));
+  EXPECT_FALSE(_tree.get(OID(_sprout, "1.0"), value));
+  EXPECT_TRUE(_tree.get(OID(_memento, "1.0"), value));
+
+  // Removing from a shard that doesn't exist does nothing.
+  _tree.remove(OID("1.2.826.0.1.1578918.9.9.1.0"));
+  EXPECT_EQ(1u, walk().size());
+}
+
+// Tests replacing and removing a subtree within a component.
+TEST_F(OIDTreeTest, Subtree)
+{
+  _tree.set(OID(_sprout, "1.1"), 1);
+  _tree.set(OID(_sprout, "1.2"), 2);
+  _tree.set(OID(_sprout, "2.1"), 3);
+
+  OIDMap update = {{OID(_sprout, "1.3"), 4}};
+  _tree.replace_subtree(OID(_sprout, 1), update);
+  EXPECT_THAT(walk(), ::testing::ElementsAre(OID(_sprout, "1.3").to_string(),
+                                             OID(_sprout, "2.1").to_string()));
+
+  _tree.remove_subtree(OID(_sprout, 2));
+  EXPECT_THAT(walk(), ::testing::ElementsAre(OID(_sprout, "1.3").to_string()));
+
+  // Removing a subtree of a shard that doesn't exist does nothing.
+  _tree.remove_subtree(OID(_memento, 1));
+  EXPECT_EQ(1u, walk().size());
+}
+
+// Tests replacing and removing a subtree that covers whole components.
+TEST_F(OIDTreeTest, SubtreeAboveComponents)
+{
+  _tree.set(OID(_sprout, "1.0"), 1);
+  _tree.set(OID(_memento, "1.0"), 2);
+  _tree.set(OID("1.3.6.1.0"), 3);
+
+  OIDMap update = {{OID(_sprout, "2.0"), 4}};
+  _tree.replace_subtree(OID("1.2.826"), update);
+  EXPECT_THAT(walk(), ::testing::ElementsAre(OID(_sprout, "2.0").to_string(),
+                                             ".1.3.6.1.0"));
+}
+
+// Tests applying a batch of changes across components.
+TEST_F(OIDTreeTest, ApplyChanges)
+{
+  _tree.set(OID(_sprout, "1.0"), 1);
+  _tree.set(OID(_sprout, "2.0"), 2);
+
+  // An entry both removed and set ends up set, and removes from a component
+  // with no entries are ignored.
+  OIDMap sets = {{OID(_sprout, "2.0"), 3},
+                 {OID(_sprout, "3.0"), 4}};
+  std::vector<OID> removes = {OID(_sprout, "1.0"),
+                              OID(_sprout, "2.0"),
+                              OID(_memento, "1.0")};
+  _tree.apply_changes(sets, removes);
+
+  EXPECT_THAT(walk(), ::testing::ElementsAre(OID(_sprout, "2.0").to_string(),
+                                             OID(_sprout, "3.0").to_string()));
+  StatValue value;
+  EXPECT_TRUE(_tree.get(OID(_sprout, "2.0"), value));
+  EXPECT_EQ(3u, value);
+}
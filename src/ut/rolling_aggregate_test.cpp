@@ -0,0 +1,263 @@
+/**
+ * @file rolling_aggregate_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "rolling_aggregate.hpp"
+#include "zmq_message_handler.hpp"
+#include "test_interposer.hpp"
+
+// The positions of the windows in RollingAggregate::WINDOWS.
+enum {FIVE_MINUTES = 0, FIFTEEN_MINUTES = 1, HOUR = 2};
+
+class RollingAggregateTest : public ::testing::Test
+{
+public:
+  // Adds a publish of a single value at the given number of minutes after the
+  // start of the test.
+  void add_value(int minute, StatValue value)
+  {
+    _rolling.add_sample(time_at(minute), value, 0, value, value, 1);
+  }
+
+  long time_at(int minute)
+  {
+    return _start + (minute * 60);
+  }
+
+  // Checks the aggregate over a window.
+  void expect_aggregate(int window,
+                        StatValue average,
+                        StatValue variance,
+                        StatValue hwm,
+                        StatValue lwm,
+                        StatValue count)
+  {
+    RollingAggregate::Aggregate aggregate = _rolling.aggregate(window);
+    EXPECT_EQ(average, aggregate.average);
+    EXPECT_EQ(variance, aggregate.variance);
+    EXPECT_EQ(hwm, aggregate.hwm);
+    EXPECT_EQ(lwm, aggregate.lwm);
+    EXPECT_EQ(count, aggregate.count);
+  }
+
+  RollingAggregate _rolling;
+  long _start = 60000;
+};
+
+// Tests that the aggregates are all zero until something's been published.
+TEST_F(RollingAggregateTest, Empty)
+{
+  expect_aggregate(FIVE_MINUTES, 0, 0, 0, 0, 0);
+  expect_aggregate(FIFTEEN_MINUTES, 0, 0, 0, 0, 0);
+  expect_aggregate(HOUR, 0, 0, 0, 0, 0);
+
+  // A period with nothing in it doesn't count, whatever its other fields say.
+  _rolling.add_sample(time_at(0), 100, 10, 200, 50, 0);
+  expect_aggregate(FIVE_MINUTES, 0, 0, 0, 0, 0);
+  expect_aggregate(HOUR, 0, 0, 0, 0, 0);
+}
+
+// Tests that publishes are combined, weighted by their counts.
+TEST_F(RollingAggregateTest, CombinePublishes)
+{
+  _rolling.add_sample(time_at(0), 10, 4, 20, 5, 10);
+  _rolling.add_sample(time_at(0) + 30, 20, 4, 30, 2, 10);
+  _rolling.add_sample(time_at(1), 40, 0, 40, 40, 5);
+
+  // The mean is (10*10 + 20*10 + 40*5) / 25 = 20.  The mean of the squares is
+  // ((4 + 100)*10 + (4 + 400)*10 + 1600*5) / 25 = 523.2, so the variance is
+  // 123.2.
+  expect_aggregate(FIVE_MINUTES, 20, 123, 40, 2, 25);
+  expect_aggregate(FIFTEEN_MINUTES, 20, 123, 40, 2, 25);
+  expect_aggregate(HOUR, 20, 123, 40, 2, 25);
+}
+
+// Tests that each window only covers the publishes within it.
+TEST_F(RollingAggregateTest, Windows)
+{
+  add_value(0, 10);
+  add_value(40, 20);
+  add_value(50, 30);
+
+  expect_aggregate(FIVE_MINUTES, 30, 0, 30, 30, 1);
+  expect_aggregate(FIFTEEN_MINUTES, 25, 25, 30, 20, 2);
+
+  // The mean of the squares is (100 + 400 + 900) / 3 = 466.7, so the variance
+  // is 66.7.
+  expect_aggregate(HOUR, 20, 67, 30, 10, 3);
+}
+
+// Tests that old publishes expire from each window, including when their
+// bucket is reused.
+TEST_F(RollingAggregateTest, Expiry)
+{
+  add_value(0, 10);
+  add_value(40, 20);
+  add_value(50, 30);
+
+  // An empty period moves the windows on, so the five minute window is empty
+  // and the first publish has expired from the hour window.
+  _rolling.add_sample(time_at(61), 0, 0, 0, 0, 0);
+  expect_aggregate(FIVE_MINUTES, 0, 0, 0, 0, 0);
+  expect_aggregate(FIFTEEN_MINUTES, 30, 0, 30, 30, 1);
+  expect_aggregate(HOUR, 25, 25, 30, 20, 2);
+
+  // The bucket for minute 100 was last used for minute 40, which has expired,
+  // so the hour window now covers the publishes at minutes 50 and 100.
+  add_value(100, 5);
+  expect_aggregate(FIVE_MINUTES, 5, 0, 5, 5, 1);
+  expect_aggregate(HOUR, 18, 156, 30, 5, 2);
+}
+
+// Tests that resetting throws away all the publishes.
+TEST_F(RollingAggregateTest, Reset)
+{
+  add_value(0, 10);
+  add_value(1, 20);
+
+  _rolling.reset();
+  expect_aggregate(FIVE_MINUTES, 0, 0, 0, 0, 0);
+  expect_aggregate(HOUR, 0, 0, 0, 0, 0);
+
+  add_value(2, 30);
+  expect_aggregate(FIVE_MINUTES, 30, 0, 30, 30, 1);
+  expect_aggregate(HOUR, 30, 0, 30, 30, 1);
+}
+
+// Tests that windows reaching back before time began are handled.
+TEST_F(RollingAggregateTest, EarlyTimes)
+{
+  _start = 0;
+  add_value(0, 10);
+  add_value(2, 20);
+  expect_aggregate(FIVE_MINUTES, 15, 25, 20, 10, 2);
+  expect_aggregate(HOUR, 15, 25, 20, 10, 2);
+}
+
+class AccumulatedWithCountStatHandlerTest : public ::testing::Test
+{
+public:
+  AccumulatedWithCountStatHandlerTest() :
+    _root("1.2.3"),
+    _handler(_root, &_tree)
+  {
+    cwtest_completely_control_time();
+  }
+
+  virtual ~AccumulatedWithCountStatHandlerTest()
+  {
+    cwtest_reset_time();
+  }
+
+  // Applies a publish with the given sequence number of a single value.
+  void publish(StatValue seq, const std::string& value)
+  {
+    std::vector<std::string> msgs = {"stat", "OK",
+                                     value, "0", value, value, "1"};
+    _handler.check_sequence(seq);
+    _handler.apply(msgs);
+  }
+
+  // Returns the value of the given column, or -1 if it isn't in the tree.
+  long long column(int column)
+  {
+    OID oid(_root, 1);
+    oid.append(column);
+    StatValue value;
+    return _tree.get(oid, value) ? (long long)value : -1;
+  }
+
+  // Checks the columns for the aggregate over a window.
+  void expect_window(int window,
+                     long long average,
+                     long long variance,
+                     long long hwm,
+                     long long lwm,
+                     long long count)
+  {
+    int first = AccumulatedWithCountStatHandler::FIRST_ROLLING_COLUMN +
+                (window * AccumulatedWithCountStatHandler::NUM_ROLLING_FIELDS);
+    EXPECT_EQ(average, column(first));
+    EXPECT_EQ(variance, column(first + 1));
+    EXPECT_EQ(hwm, column(first + 2));
+    EXPECT_EQ(lwm, column(first + 3));
+    EXPECT_EQ(count, column(first + 4));
+  }
+
+  OID _root;
+  OIDTree _tree;
+  AccumulatedWithCountStatHandler _handler;
+};
+
+// Tests that the latest publish and the aggregate over each window are
+// exposed in columns 2-21.
+TEST_F(AccumulatedWithCountStatHandlerTest, Columns)
+{
+  EXPECT_TRUE(_handler.keeps_history());
+
+  std::vector<std::string> msgs = {"stat", "OK", "10", "4", "5", "20", "10"};
+  _handler.check_sequence(1);
+  _handler.apply(msgs);
+
+  // HWM and LWM are in the opposite order in SNMP.
+  EXPECT_EQ(10, column(2));
+  EXPECT_EQ(4, column(3));
+  EXPECT_EQ(20, column(4));
+  EXPECT_EQ(5, column(5));
+  EXPECT_EQ(10, column(6));
+  expect_window(FIVE_MINUTES, 10, 4, 20, 5, 10);
+  expect_window(FIFTEEN_MINUTES, 10, 4, 20, 5, 10);
+  expect_window(HOUR, 10, 4, 20, 5, 10);
+  EXPECT_EQ(-1, column(22));
+
+  // Ten minutes later, the first publish has expired from the five minute
+  // window only.
+  cwtest_advance_time_ms(600 * 1000);
+  publish(2, "30");
+  EXPECT_EQ(30, column(2));
+  expect_window(FIVE_MINUTES, 30, 0, 30, 30, 1);
+  expect_window(FIFTEEN_MINUTES, 12, 37, 30, 5, 11);
+  expect_window(HOUR, 12, 37, 30, 5, 11);
+}
+
+// Tests that the aggregates start again once publishes have been missed.
+TEST_F(AccumulatedWithCountStatHandlerTest, ResyncResetsAggregates)
+{
+  publish(1, "10");
+  cwtest_advance_time_ms(60 * 1000);
+  publish(2, "20");
+  expect_window(HOUR, 15, 25, 20, 10, 2);
+
+  // Publish 3 is missed.
+  cwtest_advance_time_ms(60 * 1000);
+  publish(4, "30");
+  expect_window(FIVE_MINUTES, 30, 0, 30, 30, 1);
+  expect_window(FIFTEEN_MINUTES, 30, 0, 30, 30, 1);
+  expect_window(HOUR, 30, 0, 30, 30, 1);
+
+  // The aggregates build up again from there.
+  cwtest_advance_time_ms(60 * 1000);
+  publish(5, "40");
+  expect_window(HOUR, 35, 25, 40, 30, 2);
+}
+
+// Tests that a malformed publish clears the stat, including its aggregates.
+TEST_F(AccumulatedWithCountStatHandlerTest, MalformedPublish)
+{
+  publish(1, "10");
+  EXPECT_EQ(10, column(7));
+
+  publish(2, "ten");
+  EXPECT_EQ(-1, column(2));
+  EXPECT_EQ(-1, column(7));
+}
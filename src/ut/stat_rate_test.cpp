@@ -0,0 +1,179 @@
+/**
+ * @file stat_rate_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "stat_rate.hpp"
+#include "zmq_message_handler.hpp"
+#include "test_interposer.hpp"
+
+class StatRateTest : public ::testing::Test
+{
+public:
+  StatRateTest() : _rate(StatRate::default_windows()) {}
+
+  // Adds a sample of the given count every second, for the given number of
+  // seconds from _now.
+  void add_samples(int seconds, StatValue count)
+  {
+    for (int ii = 0; ii < seconds; ii++)
+    {
+      _rate.add_sample(_now++, count);
+    }
+  }
+
+  StatRate _rate;
+  long _now = 1000;
+};
+
+// Tests that there's no rate until something's been published.
+TEST_F(StatRateTest, EmptyWindows)
+{
+  EXPECT_EQ(0u, _rate.rate(0));
+  EXPECT_EQ(0u, _rate.rate(1));
+
+  // Nor if nothing has happened in any of the periods published.
+  add_samples(10, 0);
+  EXPECT_EQ(0u, _rate.rate(0));
+  EXPECT_EQ(0u, _rate.rate(1));
+}
+
+// Tests the rate over each window, in thousandths of an event per second.
+TEST_F(StatRateTest, RateOverWindow)
+{
+  EXPECT_THAT(_rate.windows(), ::testing::ElementsAre(60, 300));
+
+  // 60 events in the last minute.
+  add_samples(10, 6);
+  EXPECT_EQ(1000u, _rate.rate(0));
+  EXPECT_EQ(200u, _rate.rate(1));
+
+  // 360 events in the last minute.
+  add_samples(50, 6);
+  EXPECT_EQ(6000u, _rate.rate(0));
+  EXPECT_EQ(1200u, _rate.rate(1));
+}
+
+// Tests that samples drop out of each window once they're older than it.
+TEST_F(StatRateTest, WindowRollOver)
+{
+  add_samples(60, 1);
+  EXPECT_EQ(1000u, _rate.rate(0));
+  EXPECT_EQ(200u, _rate.rate(1));
+
+  // The first minute's samples roll out of the one minute window, but not the
+  // five minute one.
+  add_samples(60, 2);
+  EXPECT_EQ(2000u, _rate.rate(0));
+  EXPECT_EQ(600u, _rate.rate(1));
+
+  add_samples(240, 0);
+  EXPECT_EQ(0u, _rate.rate(0));
+  EXPECT_EQ(400u, _rate.rate(1));
+
+  add_samples(60, 0);
+  EXPECT_EQ(0u, _rate.rate(1));
+}
+
+// Tests that the latest sample is kept, however old it is, until the next one
+// arrives, as publishes may be less frequent than the window.
+TEST_F(StatRateTest, InfrequentPublishes)
+{
+  _rate.add_sample(_now, 120);
+  _now += 600;
+  EXPECT_EQ(2000u, _rate.rate(0));
+
+  _rate.add_sample(_now, 60);
+  EXPECT_EQ(1000u, _rate.rate(0));
+  EXPECT_EQ(200u, _rate.rate(1));
+}
+
+// Tests that once the ring of samples is full, the oldest samples are dropped
+// even if they're still within the window.
+TEST_F(StatRateTest, RingFull)
+{
+  // Two publishes a second, so the five minute window would need 600 samples.
+  for (int ii = 0; ii < 300; ii++)
+  {
+    _rate.add_sample(_now, 1);
+    _rate.add_sample(_now, 1);
+    _now++;
+  }
+
+  EXPECT_EQ(2000u, _rate.rate(0));
+  EXPECT_EQ(StatValue(StatRate::MAX_SAMPLES * 1000 / 300), _rate.rate(1));
+
+  // The window keeps working as the ring wraps.
+  add_samples(StatRate::MAX_SAMPLES, 0);
+  EXPECT_EQ(0u, _rate.rate(0));
+  EXPECT_EQ(0u, _rate.rate(1));
+}
+
+// Tests that resetting the rate throws away all the samples.
+TEST_F(StatRateTest, Reset)
+{
+  add_samples(60, 5);
+  EXPECT_EQ(5000u, _rate.rate(0));
+
+  _rate.reset();
+  EXPECT_EQ(0u, _rate.rate(0));
+  EXPECT_EQ(0u, _rate.rate(1));
+
+  add_samples(10, 6);
+  EXPECT_EQ(1000u, _rate.rate(0));
+  EXPECT_EQ(200u, _rate.rate(1));
+}
+
+// Tests that a stat's rates are exposed alongside it, and start again when
+// publishes have been missed (e.g. because the publisher restarted and its
+// counters were reset).
+TEST(BareStatHandlerRateTest, ResyncResetsRates)
+{
+  cwtest_completely_control_time();
+
+  OIDTree tree;
+  OID stat_oid("1.2.3.1");
+  OID rate_oid("1.2.3.2");
+  BareStatHandler handler(stat_oid,
+                          &tree,
+                          ZMQMessageHandler::DEFAULT_EXPIRY,
+                          rate_oid);
+  EXPECT_TRUE(handler.keeps_history());
+
+  StatValue value;
+  for (int ii = 1; ii <= 10; ii++)
+  {
+    std::vector<std::string> msgs = {"stat", "OK", "6"};
+    handler.check_sequence(ii);
+    handler.apply(msgs);
+    cwtest_advance_time_ms(1000);
+  }
+
+  EXPECT_TRUE(tree.get(stat_oid, value));
+  EXPECT_EQ(6u, value);
+  EXPECT_TRUE(tree.get(OID(rate_oid, 60), value));
+  EXPECT_EQ(1000u, value);
+  EXPECT_TRUE(tree.get(OID(rate_oid, 300), value));
+  EXPECT_EQ(200u, value);
+
+  // The publisher restarts, so the sequence numbers go backwards.
+  std::vector<std::string> msgs = {"stat", "OK", "30"};
+  handler.check_sequence(1);
+  handler.apply(msgs);
+
+  EXPECT_TRUE(tree.get(OID(rate_oid, 60), value));
+  EXPECT_EQ(500u, value);
+  EXPECT_TRUE(tree.get(OID(rate_oid, 300), value));
+  EXPECT_EQ(100u, value);
+
+  cwtest_reset_time();
+}
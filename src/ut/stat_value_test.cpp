@@ -0,0 +1,79 @@
+/**
+ * @file stat_value_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "stat_value.hpp"
+
+// Tests that decimal values are parsed, up to the largest StatValue.
+TEST(ParseStatValueTest, Valid)
+{
+  StatValue value = 1;
+  EXPECT_TRUE(parse_stat_value("0", value));
+  EXPECT_EQ(0u, value);
+
+  EXPECT_TRUE(parse_stat_value("12345", value));
+  EXPECT_EQ(12345u, value);
+
+  EXPECT_TRUE(parse_stat_value("007", value));
+  EXPECT_EQ(7u, value);
+
+  // Past the range of an Unsigned32.
+  EXPECT_TRUE(parse_stat_value("4294967296", value));
+  EXPECT_EQ(4294967296u, value);
+
+  EXPECT_TRUE(parse_stat_value("18446744073709551615", value));
+  EXPECT_EQ(UINT64_MAX, value);
+}
+
+// Tests that only the given length of the field is parsed.
+TEST(ParseStatValueTest, Length)
+{
+  StatValue value = 0;
+  EXPECT_TRUE(parse_stat_value("1234abc", 4, value));
+  EXPECT_EQ(1234u, value);
+}
+
+// Tests that values too big for a StatValue are rejected, leaving the value
+// untouched.
+TEST(ParseStatValueTest, Overflow)
+{
+  StatValue value = 1;
+  EXPECT_FALSE(parse_stat_value("18446744073709551616", value));
+  EXPECT_FALSE(parse_stat_value("18446744073709551620", value));
+  EXPECT_FALSE(parse_stat_value("100000000000000000000", value));
+  EXPECT_EQ(1u, value);
+}
+
+// Tests that negative values are rejected.
+TEST(ParseStatValueTest, Negative)
+{
+  StatValue value = 1;
+  EXPECT_FALSE(parse_stat_value("-1", value));
+  EXPECT_FALSE(parse_stat_value("-0", value));
+  EXPECT_EQ(1u, value);
+}
+
+// Tests that anything other than digits is rejected.
+TEST(ParseStatValueTest, NonNumeric)
+{
+  StatValue value = 1;
+  EXPECT_FALSE(parse_stat_value("", value));
+  EXPECT_FALSE(parse_stat_value("ten", value));
+  EXPECT_FALSE(parse_stat_value("12a", value));
+  EXPECT_FALSE(parse_stat_value("+12", value));
+  EXPECT_FALSE(parse_stat_value(" 12", value));
+  EXPECT_FALSE(parse_stat_value("12 ", value));
+  EXPECT_FALSE(parse_stat_value("1.5", value));
+  EXPECT_FALSE(parse_stat_value("0x10", value));
+  EXPECT_EQ(1u, value);
+}
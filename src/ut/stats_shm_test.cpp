@@ -0,0 +1,332 @@
+/**
+ * @file stats_shm_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "stats_shm.hpp"
+#include "test_interposer.hpp"
+
+// Records the values applied to a stat.
+class RecordingStatHandler : public ZMQMessageHandler
+{
+public:
+  RecordingStatHandler() :
+    ZMQMessageHandler(OID("1.2.3"), NULL),
+    applied_count(0)
+  {}
+
+  void handle(std::vector<std::string> msgs) {}
+
+  void handle_values(const std::vector<StatValue>& values)
+  {
+    applied_values = values;
+    applied_count++;
+  }
+
+  std::vector<StatValue> applied_values;
+  int applied_count;
+};
+
+class StatsShmTest : public ::testing::Test
+{
+public:
+  StatsShmTest()
+  {
+    char dir_template[] = "/tmp/stats_shm_test.XXXXXX";
+    _dir = mkdtemp(dir_template);
+    _stat_to_handler["stat_a"] = &_handler_a;
+    _stat_to_handler["stat_b"] = &_handler_b;
+  }
+
+  virtual ~StatsShmTest()
+  {
+    std::string cmd = "rm -rf " + _dir;
+    int rc = system(cmd.c_str());
+    (void)rc;
+  }
+
+  // Maps the stats file as a publisher would, to write to it directly.
+  StatsShm::Region* map_region(const std::string& name)
+  {
+    int fd = open(StatsShm::path(_dir, name).c_str(), O_RDWR);
+    EXPECT_NE(-1, fd);
+    void* addr = mmap(NULL,
+                      sizeof(StatsShm::Region),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED,
+                      fd,
+                      0);
+    close(fd);
+    EXPECT_NE(MAP_FAILED, addr);
+    return (StatsShm::Region*)addr;
+  }
+
+  std::string _dir;
+  RecordingStatHandler _handler_a;
+  RecordingStatHandler _handler_b;
+  std::map<std::string, ZMQMessageHandler*> _stat_to_handler;
+};
+
+// Tests that published values are read back, and are only applied again once
+// they've been republished.
+TEST_F(StatsShmTest, PublishAndRead)
+{
+  StatsShmWriter writer("sprout", _dir);
+  StatsShmReader reader("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+
+  EXPECT_TRUE(writer.publish("stat_a", {1, 2, 0xFFFFFFFFFFULL}));
+  reader.refresh(_stat_to_handler);
+
+  EXPECT_EQ(1, _handler_a.applied_count);
+  EXPECT_THAT(_handler_a.applied_values,
+              ::testing::ElementsAre(1, 2, 0xFFFFFFFFFFULL));
+  EXPECT_TRUE(_handler_a.is_fresh((long)time(NULL)));
+  EXPECT_EQ(0, _handler_b.applied_count);
+
+  // Nothing has changed, so nothing is applied.
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(1, _handler_a.applied_count);
+
+  EXPECT_TRUE(writer.publish("stat_a", {3}));
+  EXPECT_TRUE(writer.publish("stat_b", {4, 5}));
+  reader.refresh(_stat_to_handler);
+
+  EXPECT_EQ(2, _handler_a.applied_count);
+  EXPECT_THAT(_handler_a.applied_values, ::testing::ElementsAre(3));
+  EXPECT_EQ(1, _handler_b.applied_count);
+  EXPECT_THAT(_handler_b.applied_values, ::testing::ElementsAre(4, 5));
+}
+
+// Tests that a slot isn't read while the publisher is part way through
+// updating it, and is read once the update completes.
+TEST_F(StatsShmTest, SlotBeingWritten)
+{
+  StatsShmWriter writer("sprout", _dir);
+  StatsShmReader reader("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+  EXPECT_TRUE(writer.publish("stat_a", {1}));
+
+  // Start an update, as the publisher does.
+  StatsShm::Region* region = map_region("sprout");
+  StatsShm::Slot& slot = region->slots[0];
+  uint32_t seq = slot.seq.load();
+  EXPECT_EQ(0u, seq & 1);
+  slot.seq.store(seq + 1);
+  slot.values[0] = 2;
+
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(0, _handler_a.applied_count);
+
+  // Complete the update.
+  slot.seq.store(seq + 2);
+
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(1, _handler_a.applied_count);
+  EXPECT_THAT(_handler_a.applied_values, ::testing::ElementsAre(2));
+
+  munmap(region, sizeof(StatsShm::Region));
+}
+
+// Tests that a slot claiming to hold more values than it can is only read up
+// to its end.
+TEST_F(StatsShmTest, TooManyValuesInSlot)
+{
+  StatsShmWriter writer("sprout", _dir);
+  StatsShmReader reader("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+  EXPECT_TRUE(writer.publish("stat_a", {1}));
+
+  StatsShm::Region* region = map_region("sprout");
+  region->slots[0].num_values = StatsShm::MAX_VALUES + 1;
+
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ((size_t)StatsShm::MAX_VALUES, _handler_a.applied_values.size());
+
+  munmap(region, sizeof(StatsShm::Region));
+}
+
+// Tests that every set of values read is one that was published in full, while
+// the publisher is updating the slot as fast as it can.
+TEST_F(StatsShmTest, ConsistentWhilePublishing)
+{
+  StatsShmWriter writer("sprout", _dir);
+  StatsShmReader reader("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+  EXPECT_TRUE(writer.publish("stat_a", std::vector<StatValue>(StatsShm::MAX_VALUES, 0)));
+
+  std::atomic_bool stop(false);
+  std::thread publisher([&]()
+  {
+    for (StatValue value = 1; !stop.load(); value++)
+    {
+      writer.publish("stat_a", std::vector<StatValue>(StatsShm::MAX_VALUES, value));
+    }
+  });
+
+  int inconsistent = 0;
+  for (int ii = 0; ii < 10000; ii++)
+  {
+    reader.refresh(_stat_to_handler);
+
+    const std::vector<StatValue>& values = _handler_a.applied_values;
+    if ((values.size() != StatsShm::MAX_VALUES) ||
+        (std::count(values.begin(), values.end(), values[0]) != StatsShm::MAX_VALUES))
+    {
+      inconsistent++;
+    }
+  }
+
+  stop.store(true);
+  publisher.join();
+
+  EXPECT_EQ(0, inconsistent);
+  EXPECT_LT(0, _handler_a.applied_count);
+}
+
+// Tests that the publisher creates the stats directory if need be.
+TEST_F(StatsShmTest, CreatesDirectory)
+{
+  std::string dir = _dir + "/clearwater/stats";
+  StatsShmWriter writer("sprout", dir);
+  StatsShmReader reader("sprout", dir);
+  ASSERT_TRUE(writer.open());
+
+  EXPECT_TRUE(writer.publish("stat_a", {1}));
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(1, _handler_a.applied_count);
+}
+
+// Tests that the publisher fails to start if it can't create the directory.
+TEST_F(StatsShmTest, CantCreateDirectory)
+{
+  std::string file = _dir + "/file";
+  int fd = open(file.c_str(), O_WRONLY | O_CREAT, 0644);
+  close(fd);
+
+  StatsShmWriter writer("sprout", file + "/stats");
+  EXPECT_FALSE(writer.open());
+}
+
+// Tests that the reader picks up the new file when the publisher restarts,
+// and stops reading stats when the publisher removes its file.
+TEST_F(StatsShmTest, PublisherRestarts)
+{
+  cwtest_completely_control_time();
+
+  StatsShmReader reader("sprout", _dir);
+  StatsShmWriter writer("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+  EXPECT_TRUE(writer.publish("stat_a", {1}));
+  reader.refresh(_stat_to_handler);
+  EXPECT_THAT(_handler_a.applied_values, ::testing::ElementsAre(1));
+
+  // The new file's slot has the same sequence number as the old one, but is
+  // still read.  We only check for a new file once a second.
+  StatsShmWriter new_writer("sprout", _dir);
+  ASSERT_TRUE(new_writer.open());
+  EXPECT_TRUE(new_writer.publish("stat_a", {2}));
+  reader.refresh(_stat_to_handler);
+  EXPECT_THAT(_handler_a.applied_values, ::testing::ElementsAre(1));
+
+  cwtest_advance_time_ms(1000);
+  reader.refresh(_stat_to_handler);
+  EXPECT_THAT(_handler_a.applied_values, ::testing::ElementsAre(2));
+  EXPECT_EQ(2, _handler_a.applied_count);
+
+  unlink(StatsShm::path(_dir, "sprout").c_str());
+  cwtest_advance_time_ms(1000);
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(2, _handler_a.applied_count);
+
+  cwtest_reset_time();
+}
+
+// Tests that the reader keeps reading the same file once it's checked that the
+// publisher hasn't restarted.
+TEST_F(StatsShmTest, PublisherStillRunning)
+{
+  cwtest_completely_control_time();
+
+  StatsShmReader reader("sprout", _dir);
+  StatsShmWriter writer("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+  EXPECT_TRUE(writer.publish("stat_a", {1}));
+  reader.refresh(_stat_to_handler);
+
+  cwtest_advance_time_ms(1000);
+  EXPECT_TRUE(writer.publish("stat_a", {2}));
+  reader.refresh(_stat_to_handler);
+  EXPECT_THAT(_handler_a.applied_values, ::testing::ElementsAre(2));
+  EXPECT_EQ(2, _handler_a.applied_count);
+
+  cwtest_reset_time();
+}
+
+// Tests that nothing is read if the publisher isn't running, or its file isn't
+// in a format we understand.
+TEST_F(StatsShmTest, NoUsableFile)
+{
+  cwtest_completely_control_time();
+
+  StatsShmReader reader("sprout", _dir);
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(0, _handler_a.applied_count);
+
+  // A file that's too short to hold the stats.
+  std::string path = StatsShm::path(_dir, "sprout");
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+  close(fd);
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(0, _handler_a.applied_count);
+
+  StatsShmWriter writer("sprout", _dir);
+  ASSERT_TRUE(writer.open());
+  EXPECT_TRUE(writer.publish("stat_a", {1}));
+
+  StatsShm::Region* region = map_region("sprout");
+  region->version = StatsShm::VERSION + 1;
+
+  cwtest_advance_time_ms(1000);
+  reader.refresh(_stat_to_handler);
+  EXPECT_EQ(0, _handler_a.applied_count);
+
+  munmap(region, sizeof(StatsShm::Region));
+  cwtest_reset_time();
+}
+
+// Tests that stats the file has no room for aren't published.
+TEST_F(StatsShmTest, PublishLimits)
+{
+  StatsShmWriter writer("sprout", _dir);
+  EXPECT_FALSE(writer.publish("stat_a", {1}));
+  ASSERT_TRUE(writer.open());
+
+  std::vector<StatValue> too_many_values(StatsShm::MAX_VALUES + 1, 1);
+  EXPECT_FALSE(writer.publish("stat_a", too_many_values));
+  EXPECT_FALSE(writer.publish(std::string(StatsShm::MAX_NAME_LEN, 'a'), {1}));
+
+  for (int ii = 0; ii < StatsShm::MAX_STATS; ii++)
+  {
+    EXPECT_TRUE(writer.publish("stat_" + std::to_string(ii), {1}));
+  }
+  EXPECT_FALSE(writer.publish("one_too_many", {1}));
+}
@@ -0,0 +1,154 @@
+/**
+ * @file timer_wheel_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "timer_wheel.hpp"
+#include "utils.h"
+#include "test_interposer.hpp"
+
+class TestTimer : public WheelTimer
+{
+public:
+  TestTimer() : _pop_time(0) {}
+
+  void set_pop_time(uint64_t pop_time) { _pop_time = pop_time; }
+  uint64_t get_pop_time() const { return _pop_time; }
+  bool on_wheel() { return (_wheel != nullptr); }
+
+private:
+  uint64_t _pop_time;
+};
+
+class TimerWheelTest : public ::testing::Test
+{
+public:
+  TimerWheelTest()
+  {
+    cwtest_completely_control_time();
+  }
+
+  virtual ~TimerWheelTest()
+  {
+    _wheel.clear();
+    cwtest_reset_time();
+  }
+
+  // Pops and removes the next due timer, if there is one.
+  TestTimer* pop(uint64_t now)
+  {
+    TestTimer* timer = (TestTimer*)_wheel.get_next_due_timer(now);
+
+    if (timer != nullptr)
+    {
+      _wheel.remove(timer);
+    }
+
+    return timer;
+  }
+
+  TimerWheel _wheel;
+};
+
+// Test that a timer pops at exactly its pop time, at each level of the wheel.
+TEST_F(TimerWheelTest, PopsAtPopTime)
+{
+  uint64_t delays[] = {0, 5, 1023, 1024, 30000, 5000000};
+
+  for (uint64_t delay : delays)
+  {
+    uint64_t now = Utils::get_time();
+    TestTimer timer;
+    timer.set_pop_time(now + delay);
+    _wheel.insert(&timer);
+
+    if (delay > 0)
+    {
+      EXPECT_EQ(nullptr, pop(now + delay - 1));
+      EXPECT_LE(_wheel.get_next_check_time(), now + delay);
+    }
+
+    EXPECT_EQ(&timer, pop(now + delay));
+    EXPECT_FALSE(timer.on_wheel());
+    EXPECT_EQ(UINT64_MAX, _wheel.get_next_check_time());
+
+    cwtest_advance_time_ms(delay);
+  }
+}
+
+// Test that rescheduling and removing timers takes effect.
+TEST_F(TimerWheelTest, RescheduleAndRemove)
+{
+  uint64_t now = Utils::get_time();
+  TestTimer timer1;
+  TestTimer timer2;
+
+  timer1.set_pop_time(now + 30000);
+  timer2.set_pop_time(now + 30000);
+  _wheel.insert(&timer1);
+  _wheel.insert(&timer2);
+
+  // Bring timer1 forward, and cancel timer2.
+  timer1.set_pop_time(now + 10);
+  _wheel.reschedule(&timer1);
+  EXPECT_TRUE(_wheel.remove(&timer2));
+  EXPECT_FALSE(_wheel.remove(&timer2));
+
+  EXPECT_EQ(now + 10, _wheel.get_next_check_time());
+  EXPECT_EQ(&timer1, pop(now + 10));
+  EXPECT_EQ(nullptr, pop(now + 30000));
+}
+
+// Test that timers due at the same time pop in the order they were inserted.
+TEST_F(TimerWheelTest, SameTimeInOrder)
+{
+  uint64_t now = Utils::get_time();
+  TestTimer timers[3];
+
+  for (TestTimer& timer : timers)
+  {
+    timer.set_pop_time(now + 2000);
+    _wheel.insert(&timer);
+  }
+
+  EXPECT_EQ(&timers[0], pop(now + 5000));
+  EXPECT_EQ(&timers[1], pop(now + 5000));
+  EXPECT_EQ(&timers[2], pop(now + 5000));
+  EXPECT_EQ(nullptr, pop(now + 5000));
+}
+
+// Test that the next check time allows for a timer in the outer wheel that
+// is cascaded before a timer in the inner wheel pops.
+TEST_F(TimerWheelTest, CheckTimeBeforeCascade)
+{
+  // The start of the next inner rotation of the wheel.
+  uint64_t rotation = (Utils::get_time() | 1023) + 1;
+  TestTimer outer_timer;
+  TestTimer inner_timer;
+
+  // This timer is more than a rotation away, so goes in the outer wheel, and
+  // is cascaded at the start of the rotation after next.
+  outer_timer.set_pop_time(rotation + 1100);
+  _wheel.insert(&outer_timer);
+  EXPECT_EQ(nullptr, pop(rotation + 500));
+
+  // This one is within a rotation, so goes straight in the inner wheel.
+  inner_timer.set_pop_time(rotation + 1500);
+  _wheel.insert(&inner_timer);
+
+  EXPECT_EQ(rotation + 1024, _wheel.get_next_check_time());
+  EXPECT_EQ(nullptr, pop(rotation + 1024));
+  EXPECT_EQ(rotation + 1100, _wheel.get_next_check_time());
+  EXPECT_EQ(&outer_timer, pop(rotation + 1100));
+  EXPECT_EQ(rotation + 1500, _wheel.get_next_check_time());
+  EXPECT_EQ(&inner_timer, pop(rotation + 1500));
+}
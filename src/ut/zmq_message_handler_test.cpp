@@ -0,0 +1,191 @@
+/**
+ * @file zmq_message_handler_test.cpp
+ *
+ * Copyright (C) Metaswitch Networks 2017
+ * If license terms are provided to you in a COPYING file in the root directory
+ * of the source code repository by which you are accessing this code, then
+ * the license outlined in that COPYING file applies to your use.
+ * Otherwise no rights are granted except for those provided to you by
+ * Metaswitch Networks in a separate written agreement.
+ */
+
+#include <string.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "zmq_message_handler.hpp"
+
+// A stat whose MIB defines it as a Counter64.
+class Counter64StatHandler : public BareStatHandler
+{
+public:
+  Counter64StatHandler(OID oid, OIDTree* tree) : BareStatHandler(oid, tree) {}
+  u_char asn_type(OID oid) { return ASN_COUNTER64; }
+};
+
+class ZMQMessageHandlerTest : public ::testing::Test
+{
+public:
+  ZMQMessageHandlerTest() : _root("1.2.3")
+  {
+    memset(&_var, 0, sizeof(_var));
+  }
+
+  virtual ~ZMQMessageHandlerTest()
+  {
+    snmp_reset_var_buffers(&_var);
+  }
+
+  // Applies a publish of a single field.
+  void publish(ZMQMessageHandler& handler, const std::string& field)
+  {
+    std::vector<std::string> msgs = {"stat", "OK", field};
+    handler.apply(msgs);
+  }
+
+  // Returns the number of entries in the tree.
+  int tree_size()
+  {
+    int entries = 0;
+    OID oid("1");
+    StatValue value;
+    while (_tree.get_next(oid, oid, value))
+    {
+      entries++;
+    }
+    return entries;
+  }
+
+  OID _root;
+  OIDTree _tree;
+  netsnmp_variable_list _var;
+};
+
+// Tests that each handler clears its stat on a malformed publish, rather than
+// leaving the last value in place.
+TEST_F(ZMQMessageHandlerTest, MalformedFieldClearsStat)
+{
+  BareStatHandler bare(OID(_root, 1), &_tree);
+  SingleNumberStatHandler single(OID(_root, 2), &_tree);
+  SingleNumberWithScopeStatHandler scoped(OID(_root, 3), &_tree);
+  std::vector<ZMQMessageHandler*> handlers = {&bare, &single, &scoped};
+
+  for (ZMQMessageHandler* handler : handlers)
+  {
+    publish(*handler, "10");
+  }
+  EXPECT_EQ(3, tree_size());
+
+  // A field that overflows, a negative one and a non-numeric one are all
+  // malformed.
+  std::vector<std::string> malformed = {"18446744073709551616", "-1", "ten"};
+  for (const std::string& field : malformed)
+  {
+    for (ZMQMessageHandler* handler : handlers)
+    {
+      publish(*handler, field);
+    }
+    EXPECT_EQ(0, tree_size()) << field;
+
+    for (ZMQMessageHandler* handler : handlers)
+    {
+      publish(*handler, "10");
+    }
+    EXPECT_EQ(3, tree_size());
+  }
+
+  // As is a publish with the field missing.
+  for (ZMQMessageHandler* handler : handlers)
+  {
+    std::vector<std::string> msgs = {"stat", "OK"};
+    handler->apply(msgs);
+  }
+  EXPECT_EQ(0, tree_size());
+}
+
+// Tests that a stat's rates outlive a malformed publish.
+TEST_F(ZMQMessageHandlerTest, MalformedFieldKeepsRates)
+{
+  OID stat_oid(_root, 1);
+  OID rate_oid(_root, 2);
+  BareStatHandler handler(stat_oid,
+                          &_tree,
+                          ZMQMessageHandler::DEFAULT_EXPIRY,
+                          rate_oid);
+
+  publish(handler, "60");
+  publish(handler, "ten");
+
+  StatValue value;
+  EXPECT_FALSE(_tree.get(stat_oid, value));
+  EXPECT_TRUE(_tree.get(OID(rate_oid, 60), value));
+  EXPECT_EQ(1000u, value);
+}
+
+// Tests that stats are reported as Unsigned32s by default, saturating at the
+// maximum.
+TEST_F(ZMQMessageHandlerTest, SetUnsigned32)
+{
+  BareStatHandler handler(_root, &_tree);
+
+  set_stat_value(&_var, &handler, _root, 12345);
+  EXPECT_EQ(ASN_UNSIGNED, _var.type);
+  EXPECT_EQ(12345u, (u_long)*_var.val.integer);
+
+  set_stat_value(&_var, &handler, _root, UINT32_MAX);
+  EXPECT_EQ(UINT32_MAX, (u_long)*_var.val.integer);
+
+  set_stat_value(&_var, &handler, _root, (StatValue)UINT32_MAX + 1);
+  EXPECT_EQ(UINT32_MAX, (u_long)*_var.val.integer);
+
+  set_stat_value(&_var, NULL, _root, UINT64_MAX);
+  EXPECT_EQ(ASN_UNSIGNED, _var.type);
+  EXPECT_EQ(UINT32_MAX, (u_long)*_var.val.integer);
+}
+
+// Tests that stats the MIB defines as Counter64s are reported in full.
+TEST_F(ZMQMessageHandlerTest, SetCounter64)
+{
+  Counter64StatHandler handler(_root, &_tree);
+
+  set_stat_value(&_var, &handler, _root, 0x123456789aULL);
+  EXPECT_EQ(ASN_COUNTER64, _var.type);
+  EXPECT_EQ(0x12u, _var.val.counter64->high);
+  EXPECT_EQ(0x3456789au, _var.val.counter64->low);
+}
+
+// Tests that connection counts are exposed in rows indexed by IP address,
+// each publish replacing the last.
+TEST_F(ZMQMessageHandlerTest, IPCounts)
+{
+  IPCountStatHandler handler(_root, &_tree);
+
+  std::vector<std::string> msgs = {"stat", "OK",
+                                   "10.0.0.1", "3",
+                                   "not.an.address", "4",
+                                   "::1", "ten",
+                                   "10.0.0.2"};
+  handler.apply(msgs);
+
+  StatValue value;
+  EXPECT_TRUE(_tree.get(OID(_root, "1.3.1.4.10.0.0.1"), value));
+  EXPECT_EQ(3u, value);
+  EXPECT_EQ(1, tree_size());
+
+  msgs = {"stat", "OK", "10.0.0.2", "5"};
+  handler.apply(msgs);
+  EXPECT_FALSE(_tree.get(OID(_root, "1.3.1.4.10.0.0.1"), value));
+  EXPECT_TRUE(_tree.get(OID(_root, "1.3.1.4.10.0.0.2"), value));
+  EXPECT_EQ(5u, value);
+  EXPECT_EQ(1, tree_size());
+}
+
+// Tests that stats whose fields aren't all numbers ignore values published
+// through shared memory.
+TEST_F(ZMQMessageHandlerTest, ValuesNotSupported)
+{
+  IPCountStatHandler handler(_root, &_tree);
+  handler.handle_values({1, 2});
+  EXPECT_EQ(0, tree_size());
+}
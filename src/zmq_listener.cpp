@@ -13,18 +13,11 @@
 #include "globals.hpp"
 #include <string>
 #include <vector>
+#include <map>
 #include <ctime>
 
 bool ZMQListener::connect_and_subscribe()
 {
-  // Create the context.
-  _ctx = zmq_ctx_new();
-  if (_ctx == NULL)
-  {
-    perror("zmq_ctx_new");
-    return false;
-  }
-
   // Create the socket and connect it to the host.
   _sck = zmq_socket(_ctx, ZMQ_SUB);
   if (_sck == NULL)
@@ -54,81 +47,160 @@ bool ZMQListener::connect_and_subscribe()
   return true;
 }
 
-// Listen for ZMQ publishes for a given host/port/statistic name, then
-// update the statistics structs with that information.  This loops forever,
-// so should be run in its own thread.
-void ZMQListener::handle_requests_forever()
+// Parses the status field of a publish, which is "OK", optionally followed by
+// a space and the publisher's sequence number for the stat, e.g. "OK 1234".
+bool ZMQListener::parse_status(const std::string& status,
+                               bool& has_seq,
+                               StatValue& seq)
 {
-  if (!connect_and_subscribe())
+  if (status.compare(0, 2, "OK") != 0)
   {
-    return;
-  };
-  // Main loop of the thread - listen for ZMQ publish messages. Once a
-  // whole block of data has been read, call the appropriate handler
-  // function to populate data->struct_ptr with the stats received.
-  while (1)
+    return false;
+  }
+
+  has_seq = (status.length() > 2);
+  if (has_seq)
+  {
+    return ((status[2] == ' ') &&
+            (parse_stat_value(status.c_str() + 3, status.length() - 3, seq)));
+  }
+
+  return true;
+}
+
+// Reads a publish from the socket, which must be readable, and updates the
+// statistics with the information in it.  Returns false if the socket has
+// failed.
+bool ZMQListener::handle_msg()
+{
+  std::vector<std::string> msgs;
+  if (!next_msg(msgs))
+  {
+    return false;
+  }
+
+  std::map<std::string, ZMQMessageHandler*>::iterator handler =
+                                 _node_data->stat_to_handler.find(msgs[0]);
+  if (handler != _node_data->stat_to_handler.end())
   {
-    // Spin round until we've got all the messages in this block.
-    int64_t more = 0;
-    size_t more_sz = sizeof(more);
-    std::vector<std::string> msgs;
-    int rc;
+    handler->second->update_last_seen_time();
 
-    do
+    bool has_seq;
+    StatValue seq;
+    if ((msgs.size() >= 2) && (parse_status(msgs[1], has_seq, seq)))
     {
-      zmq_msg_t msg;
-      if (zmq_msg_init(&msg) != 0)
+      if (has_seq)
       {
-        perror("zmq_msg_init");
-        return;
+        handler->second->check_sequence(seq);
       }
-      while (((rc = zmq_msg_recv(&msg, _sck, 0)) == -1) && (errno == EINTR))
-      {
-        // Ignore possible errors caused by a syscall being interrupted by a signal. This can 
-        // occur at start-up due to SIGRT_1 (for which snmpd does not apparently set SA_RESTART). 
-      }
-      if (rc == -1)
+
+      if ((_node_data->lazy_parse) && (!handler->second->keeps_history()))
       {
-        perror("zmq_msg_recv");
-        return;
+        handler->second->store_pending(msgs);
       }
-      msgs.push_back(std::string((char*)zmq_msg_data(&msg), zmq_msg_size(&msg)));
-      while (((rc = zmq_getsockopt(_sck, ZMQ_RCVMORE, &more, &more_sz)) == -1) && (errno == EINTR))
+      else
       {
-        // Ignore possible errors caused by a syscall being interrupted by a signal. This can 
-        // occur at start-up due to SIGRT_1 (for which snmpd does not apparently set SA_RESTART). 
+        handler->second->apply(msgs);
       }
-      if (rc == -1)
+    }
+  }
+
+  return true;
+}
+
+// Reads a whole block of messages from the socket.
+bool ZMQListener::next_msg(std::vector<std::string>& msgs)
+{
+  // Spin round until we've got all the messages in this block.
+  int64_t more = 0;
+  size_t more_sz = sizeof(more);
+  int rc;
+
+  do
+  {
+    zmq_msg_t msg;
+    if (zmq_msg_init(&msg) != 0)
+    {
+      perror("zmq_msg_init");
+      return false;
+    }
+    while (((rc = zmq_msg_recv(&msg, _sck, 0)) == -1) && (errno == EINTR))
+    {
+      // Ignore possible errors caused by a syscall being interrupted by a signal. This can 
+      // occur at start-up due to SIGRT_1 (for which snmpd does not apparently set SA_RESTART). 
+    }
+    if (rc == -1)
+    {
+      perror("zmq_msg_recv");
+      return false;
+    }
+    msgs.push_back(std::string((char*)zmq_msg_data(&msg), zmq_msg_size(&msg)));
+    while (((rc = zmq_getsockopt(_sck, ZMQ_RCVMORE, &more, &more_sz)) == -1) && (errno == EINTR))
+    {
+      // Ignore possible errors caused by a syscall being interrupted by a signal. This can 
+      // occur at start-up due to SIGRT_1 (for which snmpd does not apparently set SA_RESTART). 
+    }
+    if (rc == -1)
+    {
+      perror("zmq_getsockopt");
+      return false;
+    }
+    zmq_msg_close(&msg);
+  }
+  while (more);
+
+  return true;
+}
+
+// Drops the subscription to any stat that the NMS hasn't polled for a while
+// (so that we don't spend time parsing publishes that nobody reads), and
+// restores the subscription to any such stat that has since been polled.
+void ZMQListener::update_subscriptions()
+{
+  if (_node_data->idle_unsubscribe_time <= 0)
+  {
+    return;
+  }
+
+  long now = (long)time(NULL);
+
+  for (std::vector<std::string>::iterator it = _node_data->stats.begin();
+       it != _node_data->stats.end();
+       it++)
+  {
+    ZMQMessageHandler* handler = _node_data->stat_to_handler.at(*it);
+
+    if (handler->is_unsubscribed())
+    {
+      if (handler->last_access_time() >= _unsubscribe_times[*it])
       {
-        perror("zmq_getsockopt");
-        return;
+        if (zmq_setsockopt(_sck, ZMQ_SUBSCRIBE, it->c_str(), it->length()) != 0)
+        {
+          perror("zmq_setsockopt");
+          continue;
+        }
+        handler->set_resubscribed(now);
       }
-      zmq_msg_close(&msg);
     }
-    while (more);
-    last_seen_time.store(time(NULL));
-    if ((msgs.size() >= 2) && (msgs[1].compare("OK") == 0))
+    else if ((now - handler->last_access_time()) >= _node_data->idle_unsubscribe_time)
     {
-      std::string message_type = msgs[0];
-      ZMQMessageHandler* handler = _node_data->stat_to_handler.at(message_type);
-      handler->handle(msgs);
+      if (zmq_setsockopt(_sck, ZMQ_UNSUBSCRIBE, it->c_str(), it->length()) != 0)
+      {
+        perror("zmq_setsockopt");
+        continue;
+      }
+      _unsubscribe_times[*it] = now;
+      handler->set_unsubscribed();
     }
   }
-};
+}
 
 ZMQListener::~ZMQListener()
 {
-  // Close the socket.
-  if (zmq_close(_sck) != 0)
+  // Close the socket.  The context belongs to the stats host.
+  if ((_sck != NULL) && (zmq_close(_sck) != 0))
   {
     perror("zmq_close");
   }
   _sck = NULL;
-
-  // Destroy the context.
-  if (zmq_ctx_destroy(_ctx) != 0)
-  {
-    perror("zmq_ctx_destroy");
-  }
-  _ctx = NULL;
 }
@@ -7,10 +7,128 @@
  * Metaswitch Networks in a separate written agreement.
 */
 
+#include <cstdint>
+
 #include "zmq_message_handler.hpp"
 #include "nodedata.hpp"
 #include "globals.hpp"
-#include <cstdlib>
+
+bool ZMQMessageHandler::owns(OID oid)
+{
+  for (std::vector<OID>::iterator it = _subtrees.begin();
+       it != _subtrees.end();
+       ++it)
+  {
+    // subtree_contains also matches OIDs above the subtree root.
+    if ((oid.get_len() >= it->get_len()) && (it->subtree_contains(oid)))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ZMQMessageHandler::owns_after(OID oid, const OID* limit)
+{
+  for (std::vector<OID>::iterator it = _subtrees.begin();
+       it != _subtrees.end();
+       ++it)
+  {
+    // A subtree holds the OIDs from its root up to (but not including) its
+    // root with the last element incremented.
+    OID end(it->get_ptr(), it->get_len() - 1);
+    end.append(it->get_ptr()[it->get_len() - 1] + 1);
+
+    bool ends_after_oid = (snmp_oid_compare(end.get_ptr(), end.get_len(),
+                                            oid.get_ptr(), oid.get_len()) > 0);
+    bool starts_within_limit = ((limit == NULL) ||
+                                (snmp_oid_compare(it->get_ptr(), it->get_len(),
+                                                  limit->get_ptr(),
+                                                  limit->get_len()) <= 0));
+
+    if ((ends_after_oid) && (starts_within_limit))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ZMQMessageHandler::parse_field(const std::string& field, StatValue& value)
+{
+  if (!parse_stat_value(field, value))
+  {
+    snmp_log(LOG_WARNING,
+             "Ignoring malformed value '%s' for stat %s",
+             field.c_str(),
+             _root_oid.to_string().c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool ZMQMessageHandler::parse_fields(const std::vector<std::string>& msgs,
+                                     size_t num_fields,
+                                     std::vector<StatValue>& values)
+{
+  // First two entries are the statistic name and the string "OK", so skip
+  // them.
+  if (msgs.size() < num_fields + 2)
+  {
+    return false;
+  }
+
+  values.resize(num_fields);
+  for (size_t ii = 0; ii < num_fields; ii++)
+  {
+    if (!parse_field(msgs[ii + 2], values[ii]))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void ZMQMessageHandler::check_sequence(StatValue seq)
+{
+  if ((_has_seq) && (seq != _last_seq + 1))
+  {
+    if (seq > _last_seq)
+    {
+      uint64_t missed = seq - _last_seq - 1;
+      _gap_count += missed;
+      snmp_log(LOG_WARNING,
+               "Missed %llu publishes for stat %s (%llu in total)",
+               (unsigned long long)missed,
+               _root_oid.to_string().c_str(),
+               (unsigned long long)_gap_count.load());
+    }
+    else
+    {
+      // The sequence number has gone backwards, so the publisher has
+      // restarted.
+      snmp_log(LOG_INFO,
+               "Publisher restarted for stat %s",
+               _root_oid.to_string().c_str());
+    }
+
+    _resync_needed.store(true);
+  }
+
+  _has_seq = true;
+  _last_seq = seq;
+}
+
+void ZMQMessageHandler::handle_values(const std::vector<StatValue>& values)
+{
+  snmp_log(LOG_WARNING,
+           "Stat %s can't be published through shared memory",
+           _root_oid.to_string().c_str());
+}
 
 void IPCountStatHandler::handle(std::vector<std::string> msgs)
 {
@@ -26,46 +144,73 @@ void IPCountStatHandler::handle(std::vector<std::string> msgs)
 
     if (oid_addr.isValid())
     {
-      OID this_oid = _root_oid;
-
-      // The root OIDs for the ConnectionCount tables (bonoConnectedSproutsTable,
-      // sproutConnectedHomersTable, sproutConnectedHomesteadsTable and
-      // mementoConnectedHomesteadsTable) don't contain the element for the
-      // table Entry (always "1") or the element for the ConnectionCount
-      // (always "3"), so insert these before adding the IP address index.
-      this_oid.append("1.3");
-      this_oid.append(oid_addr);
-
-      int connections_to_this_ip = atoi(it_val->c_str());
-      new_subtree[this_oid] = connections_to_this_ip;
+      StatValue connections_to_this_ip;
+      if (parse_field(*it_val, connections_to_this_ip))
+      {
+        // Add the IP address index to the root.1.3 prefix.
+        _row_oid.truncate(_row_prefix_len);
+        _row_oid.append(oid_addr);
+        new_subtree[_row_oid] = connections_to_this_ip;
+      }
     }
   }
   _tree->replace_subtree(_root_oid, new_subtree);
 }
 
+// A malformed publish clears the stat, but not its rates, which cover the
+// earlier publishes.
 void BareStatHandler::handle(std::vector<std::string> msgs)
 {
-  // First two entries are the statistic name and the string "OK", so
-  // skip them
-  if (msgs.size() >= 3)
+  std::vector<StatValue> values;
+  if (!parse_fields(msgs, 1, values))
+  {
+    values.clear();
+  }
+  handle_values(values);
+}
+
+void BareStatHandler::handle_values(const std::vector<StatValue>& values)
+{
+  if (values.size() >= 1)
+  {
+    StatValue value = values[0];
+    _tree->set(_root_oid, value);
+
+    if (_rate != NULL)
+    {
+      _rate->add_sample((long)time(NULL), value);
+
+      for (size_t ii = 0; ii < _rate->windows().size(); ii++)
+      {
+        _rate_cell_oid = _rate_oid;
+        _rate_cell_oid.append(_rate->windows()[ii]);
+        _tree->set(_rate_cell_oid, _rate->rate(ii));
+      }
+    }
+  }
+  else
   {
-    _tree->set(_root_oid, atoi(msgs[2].c_str()));
+    _tree->remove(_root_oid);
   }
 }
 
+// A malformed publish clears the stat, rather than leaving the old value in
+// place.
 void SingleNumberStatHandler::handle(std::vector<std::string> msgs)
 {
-  if (msgs.size() >= 3)
-  {
-    OIDMap new_subtree;
-  
-    OID this_oid = _root_oid;
-    this_oid.append("0"); // Indicates a scalar value in SNMP
-  
-    // First two entries are the statistic name and the string "OK", so
-    // skip them
-  
-    new_subtree[this_oid] = atoi(msgs[2].c_str());
+  std::vector<StatValue> values;
+  if (!parse_fields(msgs, 1, values))
+  {
+    values.clear();
+  }
+  handle_values(values);
+}
+
+void SingleNumberStatHandler::handle_values(const std::vector<StatValue>& values)
+{
+  if (values.size() >= 1)
+  {
+    OIDMap new_subtree = {{_scalar_oid, values[0]}};
     _tree->replace_subtree(_root_oid, new_subtree);
   }
   else
@@ -79,16 +224,19 @@ void SingleNumberStatHandler::handle(std::vector<std::string> msgs)
 // changes.
 void SingleNumberWithScopeStatHandler::handle(std::vector<std::string> msgs)
 {
-  if (msgs.size() >= 3)
+  std::vector<StatValue> values;
+  if (!parse_fields(msgs, 1, values))
   {
-    OIDMap new_subtree;
-  
-    OID count_oid = _root_oid;
-    count_oid.append("1.2");
-  
-    // First two entries are the statistic name and the string "OK", so
-    // skip them
-    new_subtree[count_oid] = atoi(msgs[2].c_str());
+    values.clear();
+  }
+  handle_values(values);
+}
+
+void SingleNumberWithScopeStatHandler::handle_values(const std::vector<StatValue>& values)
+{
+  if (values.size() >= 1)
+  {
+    OIDMap new_subtree = {{_count_oid, values[0]}};
     _tree->replace_subtree(_root_oid, new_subtree);
   }
   else
@@ -101,33 +249,45 @@ void SingleNumberWithScopeStatHandler::handle(std::vector<std::string> msgs)
 // as well as a total count
 void AccumulatedWithCountStatHandler::handle(std::vector<std::string> msgs)
 {
-  if (msgs.size() >= 7)
-  {
-    OID average_oid = _root_oid;
-    average_oid.append("1.2");
-   
-    OID variance_oid = _root_oid;
-    variance_oid.append("1.3");
-   
-    OID hwm_oid = _root_oid;
-    hwm_oid.append("1.4");
-   
-    OID lwm_oid = _root_oid;
-    lwm_oid.append("1.5");
-   
-    OID count_oid = _root_oid;
-    count_oid.append("1.6");
-   
-    // First two entries are the statistic name and the string "OK", so
-    // skip them
-    OIDMap new_subtree = {{average_oid, atoi(msgs[2].c_str())},
-                          {variance_oid, atoi(msgs[3].c_str())},
+  std::vector<StatValue> values;
+  if (!parse_fields(msgs, 5, values))
+  {
+    values.clear();
+  }
+  handle_values(values);
+}
+
+void AccumulatedWithCountStatHandler::handle_values(const std::vector<StatValue>& values)
+{
+  if (values.size() >= 5)
+  {
     // Note that HWM and LWM are in a different order in SNMP and 0MQ
-                          {hwm_oid, atoi(msgs[5].c_str())},
-                          {lwm_oid, atoi(msgs[4].c_str())},
-                          {count_oid, atoi(msgs[6].c_str())}
+    StatValue average = values[0];
+    StatValue variance = values[1];
+    StatValue lwm = values[2];
+    StatValue hwm = values[3];
+    StatValue count = values[4];
+    OIDMap new_subtree = {{_average_oid, average},
+                          {_variance_oid, variance},
+                          {_hwm_oid, hwm},
+                          {_lwm_oid, lwm},
+                          {_count_oid, count}
     };
-   
+
+    _rolling.add_sample((long)time(NULL), average, variance, hwm, lwm, count);
+
+    for (int window = 0; window < RollingAggregate::NUM_WINDOWS; window++)
+    {
+      RollingAggregate::Aggregate aggregate = _rolling.aggregate(window);
+      std::vector<OID>::iterator column = _rolling_oids.begin() +
+                                          window * NUM_ROLLING_FIELDS;
+      new_subtree[*column++] = aggregate.average;
+      new_subtree[*column++] = aggregate.variance;
+      new_subtree[*column++] = aggregate.hwm;
+      new_subtree[*column++] = aggregate.lwm;
+      new_subtree[*column++] = aggregate.count;
+    }
+
     _tree->replace_subtree(_root_oid, new_subtree);
   }
   else
@@ -135,3 +295,27 @@ void AccumulatedWithCountStatHandler::handle(std::vector<std::string> msgs)
     _tree->remove_subtree(_root_oid);
   }
 }
+
+void set_stat_value(netsnmp_variable_list* var,
+                    ZMQMessageHandler* stat_handler,
+                    OID& stat_oid,
+                    StatValue value)
+{
+  if ((stat_handler != NULL) &&
+      (stat_handler->asn_type(stat_oid) == ASN_COUNTER64))
+  {
+    struct counter64 c64;
+    c64.high = (u_long)(value >> 32);
+    c64.low = (u_long)(value & 0xffffffff);
+    snmp_set_var_typed_value(var, ASN_COUNTER64,
+                             (u_char*)&c64,
+                             sizeof(c64));
+  }
+  else
+  {
+    unsigned int retval = (value > UINT32_MAX) ? UINT32_MAX : (unsigned int)value;
+    snmp_set_var_typed_value(var, ASN_UNSIGNED,
+                             (u_char*)&retval,
+                             sizeof(retval));
+  }
+}